@@ -0,0 +1,48 @@
+/** @file context.h
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief Macros for passing the game context (game_ctx_t, defined in game.h)
+          to every function that reads or changes the state of a game.
+
+    Functions are declared with GAME_CTX (no other parameters) or GAME_CTX_
+    (before the other parameters), are called with CTX or CTX_, and reach the
+    state through ctx, e.g.
+
+        void shift_all_walls(GAME_CTX);
+        uint8_t get_col_pattern(GAME_CTX_ uint8_t col) { return ctx->walls.wall_cols[col]; }
+        get_col_pattern(CTX_ get_player_col(CTX));
+
+    Normally there is a single game, game_ctx (in game.c), and the macros
+    vanish: no pointer is passed and ctx is a constant pointer to it, which the
+    compiler folds away, so the code compiled for the funkit is the same as it
+    would be for plain globals. Built with
+    GAME_REENTRANT, ctx is a real parameter and any number of games can be run
+    side by side, as tools/batch does.
+*/
+
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+typedef struct game_ctx game_ctx_t;
+
+#ifdef GAME_REENTRANT
+
+#define GAME_CTX game_ctx_t* ctx
+#define GAME_CTX_ game_ctx_t* ctx,
+#define CTX ctx
+#define CTX_ ctx,
+
+#else
+
+extern game_ctx_t game_ctx;
+
+#define GAME_CTX void
+#define GAME_CTX_
+#define CTX
+#define CTX_
+
+static game_ctx_t* const ctx = &game_ctx;
+
+#endif
+
+#endif
@@ -0,0 +1,338 @@
+/** @file entity.c
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief Entity module, a fixed size pool for the things on the board other
+          than walls and the player: powerups, moving hazards and bonus pickups.
+          Entities are stored as a struct of arrays with a bit per slot marking the
+          slots in use, and each type's behaviour is looked up in a table rather than
+          branched on. Positions are also kept as per type row bitmasks for every
+          column, so collisions with the player or walls are a single AND, and as
+          slot bitmasks for every row and column, so the entity in a cell is found
+          with another AND instead of a search.
+*/
+
+#include "entity.h"
+#include "snapshot.h"
+#include "game.h"
+#include "state_hash.h"
+#include <string.h>
+
+#define POWERUP_FLASH_STATES 31 /* powerup LED is only on for 1 of every 31 updates */
+#define HAZARD_MOVE_PERIOD 100 /* updates between each step a hazard takes */
+#define HAZARD_BLINK_BIT 0x10 /* hazard LED toggles every 16 updates */
+#define BONUS_BLINK_BIT 0x40 /* bonus LED toggles every 64 updates */
+
+#define HAZARD_MOVING_LEFT 0x80 /* hazard state bit for its direction, the rest counts updates */
+#define HAZARD_COUNTER_MASK 0x7F
+
+/** Behaviour of one type of entity */
+typedef struct
+{
+    void (*update)(GAME_CTX_ uint8_t id); /* called once per entity_update_all() */
+    bool (*is_lit)(GAME_CTX_ uint8_t id); /* whether the entity's LED should be on */
+
+} entity_ops_t;
+
+
+/** Returns a row bitmask of the entities of the given types in a column */
+static uint8_t occupied_rows(GAME_CTX_ uint8_t types, uint8_t col)
+{
+    uint8_t rows = 0;
+
+    for (uint8_t type = 0; type < ENTITY_NUM_TYPES; type++) {
+        if (types & ENTITY_TYPE_BIT(type)) {
+            rows |= ctx->entities.occupancy[type][col];
+        }
+    }
+
+    return rows;
+}
+
+/** Sets the rows of a column holding an entity of a type, the one place occupancy is written
+    (other than clearing or restoring the pool) */
+static void set_occupancy(GAME_CTX_ uint8_t type, uint8_t col, uint8_t rows)
+{
+    STATE_HASH_SET(STATE_HASH_OCCUPANCY + type * LEDMAT_COLS_NUM + col, ctx->entities.occupancy[type][col], rows);
+}
+
+/** Returns a slot bitmask of the entity in a cell, 0 if the cell is empty */
+static uint8_t slot_at(GAME_CTX_ uint8_t row, uint8_t col)
+{
+    return ctx->entities.col_slots[col] & ctx->entities.row_slots[row];
+}
+
+/** Adds an entity to the bitmasks of the cell it is in */
+static void place_entity(GAME_CTX_ uint8_t id)
+{
+    uint8_t type = ctx->entities.type[id];
+    uint8_t row = ctx->entities.row[id];
+    uint8_t col = ctx->entities.col[id];
+
+    set_occupancy(CTX_ type, col, ctx->entities.occupancy[type][col] | 1 << row);
+    ctx->entities.col_slots[col] |= 1 << id;
+    ctx->entities.row_slots[row] |= 1 << id;
+}
+
+/** Removes an entity from the bitmasks of the cell it is in */
+static void lift_entity(GAME_CTX_ uint8_t id)
+{
+    uint8_t type = ctx->entities.type[id];
+    uint8_t row = ctx->entities.row[id];
+    uint8_t col = ctx->entities.col[id];
+
+    set_occupancy(CTX_ type, col, ctx->entities.occupancy[type][col] & ~(1 << row));
+    ctx->entities.col_slots[col] &= ~(1 << id);
+    ctx->entities.row_slots[row] &= ~(1 << id);
+}
+
+/** Moves an entity to a new cell, keeping the bitmasks up to date */
+static void move_entity(GAME_CTX_ uint8_t id, uint8_t row, uint8_t col)
+{
+    lift_entity(CTX_ id);
+    ctx->entities.row[id] = row;
+    ctx->entities.col[id] = col;
+    place_entity(CTX_ id);
+}
+
+static void powerup_update(GAME_CTX_ uint8_t id)
+{
+    ctx->entities.state[id] = (ctx->entities.state[id] + 1) % POWERUP_FLASH_STATES;
+}
+
+static bool powerup_is_lit(GAME_CTX_ uint8_t id)
+{
+    return ctx->entities.state[id] == 0;
+}
+
+/** Hazards step along their row every HAZARD_MOVE_PERIOD updates, turning around at
+    the edges of the board or when the next cell is taken */
+static void hazard_update(GAME_CTX_ uint8_t id)
+{
+    uint8_t state = ctx->entities.state[id];
+
+    if ((state & HAZARD_COUNTER_MASK) < HAZARD_MOVE_PERIOD) {
+        ctx->entities.state[id] = state + 1;
+        return;
+    }
+
+    uint8_t col = ctx->entities.col[id];
+    bool moving_left = state & HAZARD_MOVING_LEFT;
+
+    if ((moving_left && col == 0) || (!moving_left && col == LEDMAT_COLS_NUM - 1)) {
+        moving_left = !moving_left;
+    }
+
+    uint8_t next_col = moving_left ? col - 1 : col + 1;
+
+    if (slot_at(CTX_ ctx->entities.row[id], next_col)) {
+        moving_left = !moving_left;
+    } else {
+        move_entity(CTX_ id, ctx->entities.row[id], next_col);
+    }
+
+    ctx->entities.state[id] = moving_left ? HAZARD_MOVING_LEFT : 0;
+}
+
+static bool hazard_is_lit(GAME_CTX_ uint8_t id)
+{
+    return ctx->entities.state[id] & HAZARD_BLINK_BIT;
+}
+
+static void bonus_update(GAME_CTX_ uint8_t id)
+{
+    ctx->entities.state[id]++;
+}
+
+static bool bonus_is_lit(GAME_CTX_ uint8_t id)
+{
+    return ctx->entities.state[id] & BONUS_BLINK_BIT;
+}
+
+/** Behaviour of each type, indexed by type */
+static const entity_ops_t entity_ops[ENTITY_NUM_TYPES] = {
+    [ENTITY_POWERUP] = {powerup_update, powerup_is_lit},
+    [ENTITY_HAZARD] = {hazard_update, hazard_is_lit},
+    [ENTITY_BONUS] = {bonus_update, bonus_is_lit},
+};
+
+/** Removes every entity */
+void entity_init(GAME_CTX)
+{
+    ctx->entities.active_slots = 0;
+    memset(ctx->entities.occupancy, 0, sizeof(ctx->entities.occupancy));
+    memset(ctx->entities.col_slots, 0, sizeof(ctx->entities.col_slots));
+    memset(ctx->entities.row_slots, 0, sizeof(ctx->entities.row_slots));
+    memset(ctx->entities.lit_pattern, 0, sizeof(ctx->entities.lit_pattern));
+}
+
+/** Adds an entity to the board
+    @Param type one of the ENTITY_ types
+    @Param row, col where to put it
+    @Return the entity's id, or ENTITY_NONE if the cell is taken or the pool is full */
+uint8_t entity_spawn(GAME_CTX_ uint8_t type, uint8_t row, uint8_t col)
+{
+    uint8_t free_slots = ~ctx->entities.active_slots;
+
+    if (free_slots == 0 || slot_at(CTX_ row, col)) {
+        return ENTITY_NONE;
+    }
+
+    uint8_t id = __builtin_ctz(free_slots);
+
+    ctx->entities.type[id] = type;
+    ctx->entities.row[id] = row;
+    ctx->entities.col[id] = col;
+    ctx->entities.state[id] = (type == ENTITY_HAZARD && col >= LEDMAT_COLS_NUM / 2) ? HAZARD_MOVING_LEFT : 0;
+
+    place_entity(CTX_ id);
+    ctx->entities.lit_pattern[col] |= entity_ops[type].is_lit(CTX_ id) << row;
+    ctx->entities.active_slots |= 1 << id;
+
+    return id;
+}
+
+/** Removes an entity from the board */
+void entity_despawn(GAME_CTX_ uint8_t id)
+{
+    lift_entity(CTX_ id);
+    ctx->entities.lit_pattern[ctx->entities.col[id]] &= ~(1 << ctx->entities.row[id]);
+    ctx->entities.active_slots &= ~(1 << id);
+}
+
+/** Updates every entity (animation and movement) and works out which LEDs are on */
+void entity_update_all(GAME_CTX)
+{
+    memset(ctx->entities.lit_pattern, 0, sizeof(ctx->entities.lit_pattern));
+
+    for (uint8_t slots = ctx->entities.active_slots; slots != 0; slots &= slots - 1) {
+        uint8_t id = __builtin_ctz(slots);
+        const entity_ops_t* ops = &entity_ops[ctx->entities.type[id]];
+
+        ops->update(CTX_ id);
+        ctx->entities.lit_pattern[ctx->entities.col[id]] |= ops->is_lit(CTX_ id) << ctx->entities.row[id];
+    }
+}
+
+/** Returns a row bitmask of the entity LEDs that are on in a column */
+uint8_t entity_get_lit_pattern(GAME_CTX_ uint8_t col)
+{
+    return ctx->entities.lit_pattern[col];
+}
+
+/** Returns a row bitmask of the entities of the given types in a column
+    @Param types bitmask (ENTITY_TYPE_BIT) of the types to look for */
+uint8_t entity_get_rows(GAME_CTX_ uint8_t types, uint8_t col)
+{
+    return occupied_rows(CTX_ types, col);
+}
+
+/** Returns a bitmask (ENTITY_TYPE_BIT) of the types of entity in a cell */
+uint8_t entity_types_at(GAME_CTX_ uint8_t row, uint8_t col)
+{
+    uint8_t types = 0;
+
+    for (uint8_t type = 0; type < ENTITY_NUM_TYPES; type++) {
+        if (ctx->entities.occupancy[type][col] & (1 << row)) {
+            types |= ENTITY_TYPE_BIT(type);
+        }
+    }
+
+    return types;
+}
+
+/** Removes the entity in a cell if it is one of the given types, e.g. when the player picks it up
+    @Param types bitmask (ENTITY_TYPE_BIT) of the types to remove
+    @Return bitmask of the types that were removed */
+uint8_t entity_collect(GAME_CTX_ uint8_t row, uint8_t col, uint8_t types)
+{
+    uint8_t collected = entity_types_at(CTX_ row, col) & types;
+
+    if (collected != 0) {
+        entity_despawn(CTX_ __builtin_ctz(slot_at(CTX_ row, col)));
+    }
+
+    return collected;
+}
+
+/** Removes the entities of the given types that are underneath a wall
+    @Param types bitmask (ENTITY_TYPE_BIT) of the types that walls destroy
+    @Param walls row bitmask of each column holding a wall */
+void entity_crush(GAME_CTX_ uint8_t types, const uint8_t* walls)
+{
+    for (uint8_t col = 0; col < LEDMAT_COLS_NUM; col++) {
+        for (uint8_t crushed = occupied_rows(CTX_ types, col) & walls[col]; crushed != 0; crushed &= crushed - 1) {
+            entity_despawn(CTX_ __builtin_ctz(slot_at(CTX_ __builtin_ctz(crushed), col)));
+        }
+    }
+}
+
+/** Removes every entity of the given types
+    @Param types bitmask (ENTITY_TYPE_BIT) of the types to remove */
+void entity_clear_types(GAME_CTX_ uint8_t types)
+{
+    for (uint8_t slots = ctx->entities.active_slots; slots != 0; slots &= slots - 1) {
+        uint8_t id = __builtin_ctz(slots);
+
+        if (types & ENTITY_TYPE_BIT(ctx->entities.type[id])) {
+            entity_despawn(CTX_ id);
+        }
+    }
+}
+
+/** Moves an entity to another cell, keeping its state (and so its place in its animation) */
+void entity_move(GAME_CTX_ uint8_t id, uint8_t row, uint8_t col)
+{
+    uint8_t lit = (ctx->entities.lit_pattern[ctx->entities.col[id]] >> ctx->entities.row[id]) & 1;
+
+    ctx->entities.lit_pattern[ctx->entities.col[id]] &= ~(1 << ctx->entities.row[id]);
+    move_entity(CTX_ id, row, col);
+    ctx->entities.lit_pattern[col] |= lit << row;
+}
+
+/** Returns the id of the first entity of the given types, or ENTITY_NONE if there are none
+    @Param types bitmask (ENTITY_TYPE_BIT) of the types to look for */
+uint8_t entity_find(GAME_CTX_ uint8_t types)
+{
+    for (uint8_t slots = ctx->entities.active_slots; slots != 0; slots &= slots - 1) {
+        uint8_t id = __builtin_ctz(slots);
+
+        if (types & ENTITY_TYPE_BIT(ctx->entities.type[id])) {
+            return id;
+        }
+    }
+
+    return ENTITY_NONE;
+}
+
+/** Packs the pool into a snapshot */
+void entity_save(GAME_CTX_ entity_snapshot_t* snapshot)
+{
+    snapshot->active_slots = ctx->entities.active_slots;
+
+    for (uint8_t id = 0; id < ENTITY_CAPACITY; id++) {
+        snapshot->cell[id] = ctx->entities.type[id] << 6 | ctx->entities.row[id] << 3 | ctx->entities.col[id];
+        snapshot->state[id] = ctx->entities.state[id];
+    }
+}
+
+/** Unpacks the pool from a snapshot, rebuilding the bitmasks and which LEDs are on */
+void entity_restore(GAME_CTX_ const entity_snapshot_t* snapshot)
+{
+    entity_init(CTX);
+
+    for (uint8_t id = 0; id < ENTITY_CAPACITY; id++) {
+        ctx->entities.type[id] = snapshot->cell[id] >> 6;
+        ctx->entities.row[id] = (snapshot->cell[id] >> 3) & 0x07;
+        ctx->entities.col[id] = snapshot->cell[id] & 0x07;
+        ctx->entities.state[id] = snapshot->state[id];
+
+        if (snapshot->active_slots & (1 << id)) {
+            ctx->entities.occupancy[ctx->entities.type[id]][ctx->entities.col[id]] |= 1 << ctx->entities.row[id];
+            ctx->entities.col_slots[ctx->entities.col[id]] |= 1 << id;
+            ctx->entities.row_slots[ctx->entities.row[id]] |= 1 << id;
+            ctx->entities.lit_pattern[ctx->entities.col[id]] |= entity_ops[ctx->entities.type[id]].is_lit(CTX_ id) << ctx->entities.row[id];
+        }
+    }
+
+    ctx->entities.active_slots = snapshot->active_slots;
+}
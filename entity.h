@@ -0,0 +1,77 @@
+/** @file entity.h
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief Header file for entity.c, defines the entity types and the functions
+          for spawning, updating, rendering and colliding with them.
+*/
+
+#ifndef ENTITY_H
+#define ENTITY_H
+
+#include "system.h"
+#include "context.h"
+
+/** Maximum number of entities on the board at once (at most 8, one bit each) */
+#define ENTITY_CAPACITY 8
+
+/** Entity types, each has an entry in the entity_ops table (entity.c) */
+#define ENTITY_POWERUP 0 /* collected and used to clear the board */
+#define ENTITY_HAZARD 1 /* moves along its row, ends the game on contact */
+#define ENTITY_BONUS 2 /* collected for extra score */
+#define ENTITY_NUM_TYPES 3
+
+#define ENTITY_TYPE_BIT(type) (1 << (type))
+#define ENTITY_ALL_TYPES (ENTITY_TYPE_BIT(ENTITY_NUM_TYPES) - 1)
+
+#define ENTITY_NONE 0xFF
+
+/** The pool, part of the game context. A struct of arrays indexed by entity id */
+typedef struct
+{
+    uint8_t type[ENTITY_CAPACITY];
+    uint8_t row[ENTITY_CAPACITY];
+    uint8_t col[ENTITY_CAPACITY];
+    uint8_t state[ENTITY_CAPACITY];
+
+    /** bit n set when slot n holds an entity */
+    uint8_t active_slots;
+
+    /** Row bitmask of each column holding an entity of each type */
+    uint8_t occupancy[ENTITY_NUM_TYPES][LEDMAT_COLS_NUM];
+
+    /** Slot bitmask of the entities in each column and each row. A cell holds at most one entity,
+        so col_slots[col] & row_slots[row] is the slot of the one in that cell, if any. */
+    uint8_t col_slots[LEDMAT_COLS_NUM];
+    uint8_t row_slots[LEDMAT_ROWS_NUM];
+
+    /** Row bitmask of each column, of the entity LEDs that are currently on. Entities are drawn over
+        whatever else is in their cell, so the rest of their rows are off. */
+    uint8_t lit_pattern[LEDMAT_COLS_NUM];
+
+} entity_pool_t;
+
+void entity_init(GAME_CTX);
+
+uint8_t entity_spawn(GAME_CTX_ uint8_t, uint8_t, uint8_t);
+
+void entity_despawn(GAME_CTX_ uint8_t);
+
+void entity_update_all(GAME_CTX);
+
+uint8_t entity_get_lit_pattern(GAME_CTX_ uint8_t);
+
+uint8_t entity_get_rows(GAME_CTX_ uint8_t, uint8_t);
+
+uint8_t entity_types_at(GAME_CTX_ uint8_t, uint8_t);
+
+uint8_t entity_collect(GAME_CTX_ uint8_t, uint8_t, uint8_t);
+
+void entity_crush(GAME_CTX_ uint8_t, const uint8_t*);
+
+void entity_clear_types(GAME_CTX_ uint8_t);
+
+void entity_move(GAME_CTX_ uint8_t, uint8_t, uint8_t);
+
+uint8_t entity_find(GAME_CTX_ uint8_t);
+
+#endif
@@ -3,6 +3,8 @@
     @date 18 October 2021
     @brief A Hole-In-The-Wall Game designed for the UCFK4, This file contains
           the main game loop which implements the core gameplay logic and utilises supporting modules.
+          The gameplay itself only touches the game context, the funkit's display, buttons and LEDs
+          are driven from main, so built with GAME_REENTRANT (no main) it can run many games at once.
 */
 
 #include "system.h"
@@ -14,8 +16,17 @@
 #include "platforms.h"
 #include "interface.h"
 #include "button.h"
-#include "powerup.h"
+#include "entity.h"
+#include "level.h"
 #include "led.h"
+#include "scores.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "rng.h"
+#include "snapshot.h"
+#include "game.h"
+#include "state_hash.h"
+#include "led_power.h"
 
 #define PACER_RATE 500
 #define DISPLAY_RATE 500
@@ -32,287 +43,471 @@
 #define NEW_POWERUPS_PER_MINUTE 3
 #define POWERUP_SCREEN_FLASH_SECONDS 1
 
-#define MAX_EIGHT_BIT_VAL 255
+#define ENTITY_UPDATE_RATE 500
+#define BONUS_SCORE 2
 
-/** Following vars are global so we can reset them on game restart */
-static uint16_t phase_switch_counter = 0;
-static uint16_t new_platform_counter = 0;
-static bool player_has_powerup = false;
+#define MAX_EIGHT_BIT_VAL 255
+#define ALL_LEDS_PATTERN ((1 << LEDMAT_ROWS_NUM) - 1)
 
-/** While true, display is overridden to light up the whole screen (during powerup use)*/
-static bool screen_is_flashing = false;
+#ifndef GAME_REENTRANT
+/** The one and only game on the funkit (see context.h) */
+game_ctx_t game_ctx;
+#endif
 
 
 /** Returns true if the player is in the same column and row as a piece of a wall */
-bool is_player_colliding_with_platform(void)
+bool is_player_colliding_with_platform(GAME_CTX)
 {
-    return get_col_pattern(get_player_col()) & (1 << (get_player_row()));
+    return get_col_pattern(CTX_ get_player_col(CTX)) & (1 << (get_player_row(CTX)));
 
 }
 
-/** Returns true if the player is in the same row and column as a powerup that is active */
-bool is_player_colliding_with_powerup(void)
+/** Returns true if the player is in the same row and column as a hazard */
+bool is_player_colliding_with_hazard(GAME_CTX)
 {
-    return get_player_col() == get_powerup_col() && get_player_row() == get_powerup_row() && powerup_is_visible();
-
+    return entity_types_at(CTX_ get_player_row(CTX), get_player_col(CTX)) & ENTITY_TYPE_BIT(ENTITY_HAZARD);
 }
 
-/** Subroutine that handles reading input for the S3 button at READ_INPUT_RATE */
-void subroutine_read_button(void)
+/** Puts the powerup in a random cell. There is only ever one random powerup, so if it is already on
+    the board it moves there instead. */
+void create_powerup_at_random_cell(GAME_CTX)
 {
-    static uint8_t read_button_counter = 0;
+    uint8_t row = rng_next(CTX) % LEDMAT_ROWS_NUM;
+    uint8_t col = rng_next(CTX) % LEDMAT_COLS_NUM;
+    uint8_t id = entity_find(CTX_ ENTITY_TYPE_BIT(ENTITY_POWERUP));
 
-    if (read_button_counter >= PACER_RATE / READ_INPUT_RATE) {
-        button_update();
-        read_button_counter = 0;
+    if (id != ENTITY_NONE) {
+        entity_move(CTX_ id, row, col);
+    } else {
+        entity_spawn(CTX_ ENTITY_POWERUP, row, col);
     }
 
-    read_button_counter++;
+    telemetry_record(TELEMETRY_SPAWN, ENTITY_POWERUP << 12 | row << 8 | col);
 }
 
-/** Subroutine to display the current game state on the led matrix */
-void subroutine_display(void)
+/** Adds points to the score */
+void add_to_score(GAME_CTX_ uint8_t points)
 {
+    STATE_HASH_SET(STATE_HASH_SCORE, ctx->game.score, ctx->game.score + points);
+}
 
-    static uint8_t display_counter = 0;
-    static uint8_t current_render_col = 0;
-
-    if (display_counter >= PACER_RATE / DISPLAY_RATE) {
-
-        /* If something causes the screen to light up, override current column pattern with 0xFF to light all LEDs */
-        if (screen_is_flashing) {
-            ledmat_display_column(MAX_EIGHT_BIT_VAL, current_render_col);
-        } else {
-
-            /* Else render the current column with the pattern representing the current state of the walls */
-            ledmat_display_column(get_col_pattern(current_render_col), current_render_col);
-
-            /* override player led row to force it to correct state at time of column rendering*/
-            if (current_render_col == get_player_col()) {
-                set_player_led();
-            }
-
-            /* override powerup led row to force it to correct state at time of column rendering*/
-            if (current_render_col == get_powerup_col()) {
-                set_powerup_led();
-            }
-        }
-
-        current_render_col = (current_render_col + 1) % LEDMAT_COLS_NUM;
+/** Steps the authored level on by one wall creation slot, creating walls, spawning entities and changing phase as it says.
+    The score goes up every time a new wall is created */
+void create_next_level_wall(GAME_CTX)
+{
+    uint8_t arg;
+    uint8_t step;
 
+    while ((step = level_next(CTX_ &arg)) == LEVEL_STEP_SPAWN) {
+        entity_spawn(CTX_ arg >> 6, (arg >> 3) & 0x07, arg & 0x07);
     }
 
-    display_counter++;
-
+    if (step == LEVEL_STEP_WALL) {
+        create_new_wall_from_mask(CTX_ arg);
+        add_to_score(CTX_ 1);
+        telemetry_record(TELEMETRY_WALL_CREATE, ctx->game.score);
+        trace_instant("wall_created");
+    } else if (step == LEVEL_STEP_PHASE) {
+        ctx->game.in_phase_changeover_period = true;
+        trace_instant("phase_changeover");
+    }
 }
 
-/** A subroutine that creates and moves walls at the correct current rate
-    @Param in_phase_changeover_period indicates if game phase (wall direction) is currently transitioning
-    @Param score pointer whose value we increment every time a new wall is created */
-void subroutine_walls(bool in_phase_changeover_period, uint8_t* score)
+/** A subroutine that creates and moves walls at the correct current rate.
+    The score goes up every time a new wall is created */
+void subroutine_walls(GAME_CTX)
 {
 
-    static uint16_t platform_fall_counter = 0;
 
-    if (platform_fall_counter >= (PACER_RATE * 60 / get_wall_shifts_per_minute())) {
-        platform_fall_counter = 0;
-        shift_all_walls();
+    if (ctx->game.platform_fall_counter >= get_wall_shift_period(CTX)) {
+        ctx->game.platform_fall_counter = 0;
+        shift_all_walls(CTX);
+        telemetry_record(TELEMETRY_WALL_SHIFT, get_phase(CTX));
     }
 
     //Create wall and increment score at correct current rate, unless in a phase transition period.
-    if (!in_phase_changeover_period && new_platform_counter >= PACER_RATE * 60 / get_new_walls_per_minute()) {
-        new_platform_counter = 0;
-        create_new_wall();
-        *score += 1;
+    if (!ctx->game.in_phase_changeover_period && ctx->game.new_platform_counter >= get_new_wall_period(CTX)) {
+        ctx->game.new_platform_counter = 0;
+
+        if (ctx->game.playing_level) {
+            create_next_level_wall(CTX);
+        } else {
+            create_new_wall(CTX);
+            add_to_score(CTX_ 1);
+            telemetry_record(TELEMETRY_WALL_CREATE, ctx->game.score);
+            trace_instant("wall_created");
+        }
     }
 
-    platform_fall_counter++;
-    new_platform_counter++;
+    ctx->game.platform_fall_counter++;
+    ctx->game.new_platform_counter++;
 }
 
-/** Subroutine to move us to a phase transition period at rate of PHASE_SWITCHES_PER_MINUTE
-    @Param in_phase_changeover_period pointer, toggled to true at rate defined by PHASE_SWITCHES_PER_MINUTE */
-void subroutine_check_phase_switch(bool* in_phase_changeover_period)
+/** Subroutine to move us to a phase transition period at rate of PHASE_SWITCHES_PER_MINUTE */
+void subroutine_check_phase_switch(GAME_CTX)
 {
 
-    if (phase_switch_counter >= (PACER_RATE * 60 / PHASE_SWITCHES_PER_MINUTE)) {
-        phase_switch_counter = 0;
-        *in_phase_changeover_period = true;
-        new_platform_counter = 0;
+    if (ctx->game.phase_switch_counter >= (PACER_RATE * 60 / PHASE_SWITCHES_PER_MINUTE)) {
+        ctx->game.phase_switch_counter = 0;
+        ctx->game.in_phase_changeover_period = true;
+        ctx->game.new_platform_counter = 0;
+        trace_instant("phase_changeover");
     }
 
-    phase_switch_counter++;
+    ctx->game.phase_switch_counter++;
 
 }
 
 /** Subroutine to blink player LED at PLAYER_LED_BLINK_RATE */
-void subroutine_player_blink(void)
+void subroutine_player_blink(GAME_CTX)
 {
-    static uint8_t player_led_blink_counter = 0;
 
-    if (player_led_blink_counter >= PACER_RATE / PLAYER_LED_BLINK_RATE) {
-        toggle_player_led_state();
-        player_led_blink_counter = 0;
+    if (ctx->game.player_led_blink_counter >= PACER_RATE / PLAYER_LED_BLINK_RATE) {
+        toggle_player_led_state(CTX);
+        ctx->game.player_led_blink_counter = 0;
     }
 
-    player_led_blink_counter++;
+    ctx->game.player_led_blink_counter++;
 }
 
-/** Subroutine to toggle powerup LED rapidly, to make it visually distinct */
-void subroutine_powerup_modulate(void)
+/** Subroutine to animate and move every entity at ENTITY_UPDATE_RATE */
+void subroutine_entity_update(GAME_CTX)
 {
-    static uint8_t powerup_led_modulate_counter = 0;
 
-    if (powerup_is_visible() && powerup_led_modulate_counter >= PACER_RATE / POWERUP_LED_MODULATE_RATE) {
-        increment_powerup_led_state();
-        powerup_led_modulate_counter = 0;
+    if (ctx->game.entity_update_counter >= PACER_RATE / ENTITY_UPDATE_RATE) {
+        entity_update_all(CTX);
+        ctx->game.entity_update_counter = 0;
     }
 
-    powerup_led_modulate_counter++;
+    ctx->game.entity_update_counter++;
 }
 
-/**  Subroutine to read navswitch input at READ_INPUT_RATE and move player according to this input*/
-void subroutine_read_navswitch(void)
+/** Subroutine to destroy the hazards and bonus pickups that walls run over, and collect bonuses.
+    Only levels place hazards and bonuses. */
+void subroutine_hazards_and_bonuses(GAME_CTX)
 {
+    entity_crush(CTX_ ENTITY_TYPE_BIT(ENTITY_HAZARD) | ENTITY_TYPE_BIT(ENTITY_BONUS), get_wall_cols(CTX));
 
-    static uint8_t read_navswitch_counter = 0;
+    if (entity_collect(CTX_ get_player_row(CTX), get_player_col(CTX), ENTITY_TYPE_BIT(ENTITY_BONUS))) {
+        add_to_score(CTX_ BONUS_SCORE);
+        trace_instant("bonus_collected");
+    }
+}
 
-    if (read_navswitch_counter >= PACER_RATE / READ_INPUT_RATE) {
-        read_navswitch_counter = 0;
-        navswitch_update ();
-        if (navswitch_push_event_p (NAVSWITCH_EAST)) {
-            if (get_player_col() < LEDMAT_COLS_NUM - 1) {
-                set_player_col(get_player_col() + 1);
+/** Moves the player one step in the direction pushed, wrapping around the edges parallel to the walls.
+    @Param input the game_tick() input, with at most one navswitch direction set */
+void move_player(GAME_CTX_ uint8_t input)
+{
+    const phase_ops_t* ops = get_phase_ops(CTX);
 
-            //we only allow east->west wrap in horizontal wall phase
-            } else if (get_player_col() == LEDMAT_COLS_NUM - 1 && get_phase() == PHASE_HORIZONTAL_PLATFORMS) {
-                set_player_col(0);
-            }
-        } else if (navswitch_push_event_p (NAVSWITCH_WEST)) {
-            if (get_player_col() > 0) {
-                set_player_col(get_player_col() - 1);
+    if (input & (1 << NAVSWITCH_EAST)) {
+        if (get_player_col(CTX) < LEDMAT_COLS_NUM - 1) {
+            set_player_col(CTX_ get_player_col(CTX) + 1);
 
-            //we only allow west->east wrap in horizontal wall phase
-            } else if (get_player_col() == 0 && get_phase() == PHASE_HORIZONTAL_PLATFORMS) {
-                set_player_col(LEDMAT_COLS_NUM-1);
-            }
-        } else if (navswitch_push_event_p (NAVSWITCH_NORTH)) {
-            if(get_player_row() > 0) {
-                set_player_row((get_player_row() - 1));
+        //east->west wrap, if the current phase allows it
+        } else if (ops->wrap_cols) {
+            set_player_col(CTX_ 0);
+        }
+    } else if (input & (1 << NAVSWITCH_WEST)) {
+        if (get_player_col(CTX) > 0) {
+            set_player_col(CTX_ get_player_col(CTX) - 1);
 
-            //we only allow north->south wrap in vertical wall phase
-            } else if (get_player_row() == 0 && get_phase() == PHASE_VERTICAL_PLATFORMS){
-                set_player_row(LEDMAT_ROWS_NUM-1);
-            }
-        } else if (navswitch_push_event_p (NAVSWITCH_SOUTH)) {
-            if(get_player_row() < LEDMAT_ROWS_NUM - 1) {
-                set_player_row((get_player_row() + 1));
+        //west->east wrap, if the current phase allows it
+        } else if (ops->wrap_cols) {
+            set_player_col(CTX_ LEDMAT_COLS_NUM-1);
+        }
+    } else if (input & (1 << NAVSWITCH_NORTH)) {
+        if(get_player_row(CTX) > 0) {
+            set_player_row(CTX_ (get_player_row(CTX) - 1));
 
-            //we only allow south->north wrap in vertical wall phase
-            } else if (get_player_row() == LEDMAT_ROWS_NUM - 1 && get_phase() == PHASE_VERTICAL_PLATFORMS){
-                set_player_row(0);
-            }
+        //north->south wrap, if the current phase allows it
+        } else if (ops->wrap_rows){
+            set_player_row(CTX_ LEDMAT_ROWS_NUM-1);
         }
-    }
+    } else if (input & (1 << NAVSWITCH_SOUTH)) {
+        if(get_player_row(CTX) < LEDMAT_ROWS_NUM - 1) {
+            set_player_row(CTX_ (get_player_row(CTX) + 1));
 
-    read_navswitch_counter++;
+        //south->north wrap, if the current phase allows it
+        } else if (ops->wrap_rows){
+            set_player_row(CTX_ 0);
+        }
+    }
 }
 
-/** Subroutine to actually change phase at end of phase transition period. Increases speed of wall movement and creation each time.
-    @Param in_phase_changeover_period pointer, indicates if program is currently within phase transition period */
-void subroutine_phase_changeover(bool* in_phase_changeover_period)
+/** Subroutine to actually change phase at end of phase transition period. Increases speed of wall movement and creation each time. */
+void subroutine_phase_changeover(GAME_CTX)
 {
 
-    static uint16_t phase_changeover_counter = 0;
 
-    phase_changeover_counter++;
-    if (phase_changeover_counter >= PACER_RATE * PHASE_CHANGEOVER_DURATION / 10) {
-        *in_phase_changeover_period = false;
-        phase_changeover_counter = 0;
+    ctx->game.phase_changeover_counter++;
+    if (ctx->game.phase_changeover_counter >= PACER_RATE * PHASE_CHANGEOVER_DURATION / 10) {
+        ctx->game.in_phase_changeover_period = false;
+        ctx->game.phase_changeover_counter = 0;
 
         //clear any vestigial walls
-        clear_all_walls();
-
-        change_phase();
+        clear_all_walls(CTX);
 
-        increase_wall_shifts_per_minute(WALL_SPEED_INCREASE_AMOUNT);
-        increase_new_walls_per_minute(WALL_CREATE_INREASE_AMOUNT);
-    }
-
-}
+        change_phase(CTX);
+        telemetry_record(TELEMETRY_PHASE, get_phase(CTX));
+        trace_instant("phase_change");
 
-/** Subroutine to handle the text displayed on screen either before or after the game.
-    @Param game_over indicates whether game is finished so we display the right text.
-    @Param score the final score of the game, to display in game over text.
-*/
-void subroutine_interface(bool game_over, uint8_t score)
-{
-    if (!game_over) {
-        interface_set_welcome_text();
-    } else {
-        interface_set_gameover_text(score);
+        increase_wall_shifts_per_minute(CTX_ WALL_SPEED_INCREASE_AMOUNT);
+        increase_new_walls_per_minute(CTX_ WALL_CREATE_INREASE_AMOUNT);
     }
 
-    interface_update();
 }
 
 /** Subroutine to handle picking up, creating and using powerups.
-    While player has a powerup, blue LED is on. When powerup is used, blue LED turns off.
+    While player has a powerup, blue LED is on (see subroutine_display). When powerup is used, blue LED turns off.
+    @Param button_pushed whether the button was pushed this tick, which uses the powerup
 */
-void subroutine_powerup(void)
+void subroutine_powerup(GAME_CTX_ bool button_pushed)
 {
 
-    static uint16_t powerup_creation_counter = 0;
-    static uint16_t powerup_flash_screen_counter = 0;
 
     /** collect powerup */
-    if (is_player_colliding_with_powerup() && !player_has_powerup) {
-        player_has_powerup = true;
-        led_set(LED1, 1);
-        destroy_powerup();
+    if (!ctx->game.player_has_powerup && entity_collect(CTX_ get_player_row(CTX), get_player_col(CTX), ENTITY_TYPE_BIT(ENTITY_POWERUP))) {
+        STATE_HASH_SET(STATE_HASH_HAS_POWERUP, ctx->game.player_has_powerup, true);
+        telemetry_record(TELEMETRY_POWERUP, 0);
+        trace_instant("powerup_collected");
     }
 
     /** use powerup. lights up the screen*/
-    if (button_push_event_p(0) && player_has_powerup) {
-        player_has_powerup = false;
-        led_set(LED1, 0);
-        clear_all_walls();
-        screen_is_flashing = true;
+    if (button_pushed && ctx->game.player_has_powerup) {
+        STATE_HASH_SET(STATE_HASH_HAS_POWERUP, ctx->game.player_has_powerup, false);
+        ctx->game.powerups_used++;
+        clear_all_walls(CTX);
+        entity_clear_types(CTX_ ENTITY_TYPE_BIT(ENTITY_HAZARD));
+        ctx->game.screen_is_flashing = true;
+        telemetry_record(TELEMETRY_POWERUP, 1);
+        trace_instant("powerup_used");
     }
 
     /** Create powerup at rate of NEW_POWERUPS_PER_MINUTE, if player doesn't already have one */
-    if (powerup_creation_counter >= (PACER_RATE * 60) / NEW_POWERUPS_PER_MINUTE) {
-        if (!player_has_powerup) {
-            create_powerup();
+    if (ctx->game.powerup_creation_counter >= (PACER_RATE * 60) / NEW_POWERUPS_PER_MINUTE) {
+        if (!ctx->game.playing_level && !ctx->game.player_has_powerup) {
+            create_powerup_at_random_cell(CTX);
         }
-        powerup_creation_counter = 0;
+        ctx->game.powerup_creation_counter = 0;
     }
 
-    powerup_creation_counter++;
+    ctx->game.powerup_creation_counter++;
 
     /** Stop lighting up screen after POWERUP_SCREEN_FLASH_SECONDS */
-    if (screen_is_flashing) {
-        powerup_flash_screen_counter++;
+    if (ctx->game.screen_is_flashing) {
+        ctx->game.powerup_flash_screen_counter++;
 
-        if (powerup_flash_screen_counter >= PACER_RATE / POWERUP_SCREEN_FLASH_SECONDS) {
-            powerup_flash_screen_counter = 0;
-            screen_is_flashing = false;
+        if (ctx->game.powerup_flash_screen_counter >= PACER_RATE / POWERUP_SCREEN_FLASH_SECONDS) {
+            ctx->game.powerup_flash_screen_counter = 0;
+            ctx->game.screen_is_flashing = false;
         }
-        new_platform_counter = 0;
+        ctx->game.new_platform_counter = 0;
     }
 
 }
 
+/** Copies the game loop's state into a snapshot */
+void game_save(GAME_CTX_ game_state_t* state)
+{
+    *state = ctx->game;
+}
+
+/** Carries on from a saved game loop state */
+void game_restore(GAME_CTX_ const game_state_t* state)
+{
+    ctx->game = *state;
+}
+
 /** Returns game board to its initial position */
-void reset_game(void)
+void reset_game(GAME_CTX)
 {
-    walls_reset();
-    player_init();
-    phase_switch_counter = 0;
-    
+    walls_reset(CTX);
+    player_init(CTX);
+    ctx->game.phase_switch_counter = 0;
+
     //remove any status of powerup
-    led_set(LED1, 0);
-    player_has_powerup = false;
+    STATE_HASH_SET(STATE_HASH_HAS_POWERUP, ctx->game.player_has_powerup, false);
+    ctx->game.powerups_used = 0;
+}
+
+/** Sets up a game context from scratch, ready for game_start() */
+void game_init(GAME_CTX)
+{
+    *ctx = (game_ctx_t) {0};
+    player_init(CTX);
+    platforms_init(CTX_ PACER_RATE);
+    entity_init(CTX);
+    state_hash_rebuild(CTX);
+}
+
+/** Starts a new game
+    @Param level true to play the built in level, false for random walls */
+void game_start(GAME_CTX_ bool level)
+{
+    ctx->game.playing_level = level;
+    ctx->game.score = 0;
+    ctx->game.seconds_survived = 0;
+    ctx->game.game_tick_counter = 0;
+    reset_game(CTX);
+
+    //a level places its own entities. The random powerup is left on the board from game to game, but
+    //hazards and bonuses only belong to levels
+    if (ctx->game.playing_level) {
+        entity_init(CTX);
+        level_start(CTX_ level_data);
+    } else {
+        entity_clear_types(CTX_ ENTITY_TYPE_BIT(ENTITY_HAZARD) | ENTITY_TYPE_BIT(ENTITY_BONUS));
+    }
+
+    state_hash_rebuild(CTX);
+}
+
+/** Returns true once the player has collided with a wall or hazard, ending the game */
+bool game_is_over(GAME_CTX)
+{
+    return is_player_colliding_with_platform(CTX) || is_player_colliding_with_hazard(CTX);
+}
+
+/** Returns the LEDs to light in a column as ledmat_display_column() takes them, showing the walls,
+    entities and player, or every LED while the screen is flashing
+    @Param col the column to render */
+uint8_t game_get_col_pattern(GAME_CTX_ uint8_t col)
+{
+    if (ctx->game.screen_is_flashing) {
+        return ALL_LEDS_PATTERN;
+    }
+
+    uint8_t pattern = get_col_pattern(CTX_ col);
+
+    /* override player led row to force it to correct state at time of column rendering */
+    if (col == get_player_col(CTX)) {
+        pattern = (pattern & ~(1 << get_player_row(CTX))) | get_player_led_pattern(CTX);
+    }
+
+    /* then the entities, which are drawn over walls and the player in the same way */
+    return (pattern & ~entity_get_rows(CTX_ ENTITY_ALL_TYPES, col)) | entity_get_lit_pattern(CTX_ col);
+}
+
+/** Runs the animations for one tick, these carry on after the game is over */
+void game_animate(GAME_CTX)
+{
+    TRACE_CALL("subroutine_player_blink", subroutine_player_blink(CTX));
+    TRACE_CALL("subroutine_entity_update", subroutine_entity_update(CTX));
+}
+
+/** Runs one tick of a game that isn't over
+    @Param input navswitch pushes (1 << NAVSWITCH_ direction) and GAME_INPUT_BUTTON read this tick */
+void game_tick(GAME_CTX_ uint8_t input)
+{
+    game_animate(CTX);
+
+    TRACE_CALL("subroutine_walls", subroutine_walls(CTX));
+
+    //authored levels choose their own phase switches
+    if (!ctx->game.playing_level)
+        TRACE_CALL("subroutine_check_phase_switch", subroutine_check_phase_switch(CTX));
+    move_player(CTX_ input);
+
+    if (ctx->game.in_phase_changeover_period)
+        TRACE_CALL("subroutine_phase_changeover", subroutine_phase_changeover(CTX));
+
+    TRACE_CALL("subroutine_powerup", subroutine_powerup(CTX_ input & GAME_INPUT_BUTTON));
+    TRACE_CALL("subroutine_hazards_and_bonuses", subroutine_hazards_and_bonuses(CTX));
+
+    if (++ctx->game.game_tick_counter >= PACER_RATE) {
+        ctx->game.game_tick_counter = 0;
+        ctx->game.seconds_survived++;
+    }
+}
+
+#ifndef GAME_REENTRANT
+
+/** Subroutine that handles reading input for the S3 button at READ_INPUT_RATE */
+void subroutine_read_button(GAME_CTX)
+{
+
+    if (ctx->game.read_button_counter >= PACER_RATE / READ_INPUT_RATE) {
+        button_update();
+        ctx->game.read_button_counter = 0;
+
+        if (button_push_event_p(0)) {
+            telemetry_record(TELEMETRY_INPUT, TELEMETRY_INPUT_BUTTON);
+        }
+    }
+
+    ctx->game.read_button_counter++;
+}
+
+/** Subroutine to display the current game state on the led matrix, and whether the player has a powerup on the blue LED */
+void subroutine_display(GAME_CTX)
+{
+
+
+    if (ctx->game.display_counter >= PACER_RATE / DISPLAY_RATE) {
+        uint8_t pattern = game_get_col_pattern(CTX_ ctx->game.current_render_col) & ~ctx->game.render_col_shown;
+        uint8_t slice = led_power_cap_slice(pattern);
+
+        ledmat_display_column(slice, ctx->game.current_render_col);
+        led_power_slot(slice, ctx->game.player_has_powerup);
+
+        /* With LED_POWER_CAP a column with too many LEDs lit stays for more slots, until all of them have been shown */
+        if (slice == pattern) {
+            ctx->game.render_col_shown = 0;
+            ctx->game.current_render_col = (ctx->game.current_render_col + 1) % LEDMAT_COLS_NUM;
+        } else {
+            ctx->game.render_col_shown |= slice;
+        }
+
+    }
+
+    ctx->game.display_counter++;
+
+    led_set(LED1, ctx->game.player_has_powerup);
+}
+
+/**  Subroutine to read navswitch input at READ_INPUT_RATE
+     @Return the direction pushed as 1 << NAVSWITCH_ direction, or 0 */
+uint8_t subroutine_read_navswitch(GAME_CTX)
+{
+    uint8_t input = 0;
+
+    if (ctx->game.read_navswitch_counter >= PACER_RATE / READ_INPUT_RATE) {
+        ctx->game.read_navswitch_counter = 0;
+        navswitch_update ();
+        if (navswitch_push_event_p (NAVSWITCH_EAST)) {
+            input = 1 << NAVSWITCH_EAST;
+        } else if (navswitch_push_event_p (NAVSWITCH_WEST)) {
+            input = 1 << NAVSWITCH_WEST;
+        } else if (navswitch_push_event_p (NAVSWITCH_NORTH)) {
+            input = 1 << NAVSWITCH_NORTH;
+        } else if (navswitch_push_event_p (NAVSWITCH_SOUTH)) {
+            input = 1 << NAVSWITCH_SOUTH;
+        }
+
+        if (input) {
+            telemetry_record(TELEMETRY_INPUT, __builtin_ctz(input));
+        }
+    }
+
+    ctx->game.read_navswitch_counter++;
+
+    return input;
+}
+
+/** Subroutine to handle the text displayed on screen either before or after the game.
+    @Param game_over indicates whether game is finished so we display the right text.
+    @Param score the final score of the game, to display in game over text.
+*/
+void subroutine_interface(bool game_over, uint8_t score)
+{
+    if (!game_over) {
+        interface_set_welcome_text(scores_get_high_score());
+    } else {
+        interface_set_gameover_text(score);
+    }
+
+    interface_update();
 }
 
 /** initialisation and main game loop */
@@ -323,17 +518,18 @@ int main (void)
     ledmat_init();
     pacer_init(PACER_RATE);
     interface_init(PACER_RATE);
-    player_init();
-    platforms_init();
+    game_init(CTX);
     led_init();
     led_set(LED1, 0);
+    scores_init();
+    telemetry_init(PACER_RATE);
+    trace_init(PACER_RATE);
+    led_power_init(DISPLAY_RATE);
 
-    bool in_phase_changeover_period = false;
     bool game_over = false;
     bool interface_mode = true;
 
     uint16_t game_over_wait_timer = 0;
-    uint8_t score = 0;
 
     //counter to help us avoid polling buttons during funkit power on
     uint8_t first_startup_counter = 0;
@@ -341,55 +537,77 @@ int main (void)
     while (1)
     {
 
-        pacer_wait();
+        //the previous tick is over, so use the idle time before the next one to send telemetry
+        trace_tick_end();
+        telemetry_tick_end();
+        TRACE_CALL("telemetry_drain", telemetry_drain());
+
+        TRACE_CALL("pacer_wait", pacer_wait());
+        telemetry_tick_begin();
+        trace_tick();
 
         if (first_startup_counter < MAX_EIGHT_BIT_VAL)
             first_startup_counter++;
 
-        subroutine_read_button();
+        TRACE_CALL("subroutine_read_button", subroutine_read_button(CTX));
 
         /** Locks us into the interface mode until we press the button to continue */
         if (interface_mode) {
-            subroutine_interface(game_over, score);
+            TRACE_CALL("subroutine_interface", subroutine_interface(game_over, ctx->game.score));
+
+            //EEPROM is only ever written here, never during gameplay
+            scores_update();
+
+            //pushing the navswitch in starts the built in level instead of random walls
+            navswitch_update();
+            bool start_level = navswitch_push_event_p(NAVSWITCH_PUSH);
 
             //ignore button push until funkit has initialised and we've counted about half a second
-            if (button_push_event_p(0) && first_startup_counter == MAX_EIGHT_BIT_VAL) {
-                score = 0;
+            if ((button_push_event_p(0) || start_level) && first_startup_counter == MAX_EIGHT_BIT_VAL) {
+                game_start(CTX_ start_level);
+                led_power_session_start();
                 game_over = false;
                 interface_mode = false;
                 interface_clear();
-                subroutine_interface(game_over, score);
-                reset_game();
+                TRACE_CALL("subroutine_interface", subroutine_interface(game_over, ctx->game.score));
             } else {
                 continue;
             }
         }
 
-        /** game ends on player collision with a wall*/
-        game_over = is_player_colliding_with_platform();
+        /** game ends on player collision with a wall or hazard*/
+        game_over = game_is_over(CTX);
+
+        if (game_over && game_over_wait_timer == 0) {
+            telemetry_record(TELEMETRY_COLLISION, get_player_row(CTX) << 8 | get_player_col(CTX));
+            led_power_session_end();
+            trace_instant("game_over");
+        }
 
         /** game ended, and we've rubbed it in for long enough, reset game state and skip rest of loop */
         if (game_over && game_over_wait_timer >= GAME_OVER_WAIT_PERIOD * PACER_RATE) {
             interface_mode = true;
             game_over_wait_timer = 0;
-            reset_game();
+            scores_record_game(ctx->game.score, ctx->game.seconds_survived, ctx->game.powerups_used);
+            reset_game(CTX);
+            led_set(LED1, 0);
             continue;
         }
 
-        subroutine_display();
-        subroutine_player_blink();
-        subroutine_powerup_modulate();
+        TRACE_CALL("subroutine_display", subroutine_display(CTX));
 
         if (!game_over) {
-            subroutine_walls(in_phase_changeover_period, &score);
-            subroutine_check_phase_switch(&in_phase_changeover_period);
-            subroutine_read_navswitch();
+            uint8_t input;
 
-            if (in_phase_changeover_period)
-                subroutine_phase_changeover(&in_phase_changeover_period);
-
-            subroutine_powerup();
+            TRACE_CALL("subroutine_read_navswitch", input = subroutine_read_navswitch(CTX));
+            if (button_push_event_p(0)) {
+                input |= GAME_INPUT_BUTTON;
+            }
 
+            game_tick(CTX_ input);
+            state_hash_tick(CTX);
+        } else {
+            game_animate(CTX);
         }
 
         //increment the timer that controls how long we wait until we switch to game over screen
@@ -399,3 +617,5 @@ int main (void)
 
     }
 }
+
+#endif
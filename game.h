@@ -0,0 +1,76 @@
+/** @file game.h
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief Header file for game.c. Defines the game context, which holds every
+          bit of state belonging to one game, and the functions for playing a
+          game one tick at a time without the funkit (see tools/batch.c).
+*/
+
+#ifndef GAME_H
+#define GAME_H
+
+#include "system.h"
+#include "context.h"
+#include "navswitch.h"
+#include "platforms.h"
+#include "player.h"
+#include "entity.h"
+#include "level.h"
+
+/** Inputs for game_tick(), 1 << NAVSWITCH_ direction for each navswitch push */
+#define GAME_INPUT_BUTTON (1 << 7)
+
+/** State of the main game loop (game.c) */
+typedef struct
+{
+    uint16_t phase_switch_counter;
+    uint16_t new_platform_counter;
+    uint16_t platform_fall_counter;
+    uint16_t phase_changeover_counter;
+    uint16_t powerup_creation_counter;
+    uint16_t powerup_flash_screen_counter;
+    uint16_t game_tick_counter;
+    uint16_t seconds_survived;
+    uint8_t read_button_counter;
+    uint8_t display_counter;
+    uint8_t current_render_col;
+    uint8_t render_col_shown; /* LEDs of the current column already shown, when LED_POWER_CAP splits it */
+    uint8_t player_led_blink_counter;
+    uint8_t entity_update_counter;
+    uint8_t read_navswitch_counter;
+    uint8_t score;
+    uint8_t powerups_used;
+    bool player_has_powerup;
+    bool screen_is_flashing;
+    bool in_phase_changeover_period;
+    bool playing_level;
+
+} game_state_t;
+
+/** Everything about one game */
+struct game_ctx
+{
+    game_state_t game;
+    walls_t walls;
+    player_t player;
+    entity_pool_t entities;
+    level_t level;
+    uint16_t rng_state;
+#ifdef STATE_HASH
+    uint16_t state_hash;
+#endif
+};
+
+void game_init(GAME_CTX);
+
+void game_start(GAME_CTX_ bool);
+
+bool game_is_over(GAME_CTX);
+
+void game_animate(GAME_CTX);
+
+void game_tick(GAME_CTX_ uint8_t);
+
+uint8_t game_get_col_pattern(GAME_CTX_ uint8_t);
+
+#endif
@@ -14,6 +14,13 @@
 
 #define TEXT_SCROLL_SPEED 15
 #define GREETING_TEXT "Welcome. Press button to start."
+#define HIGH_SCORE_GREETING_TEXT "Welcome. Best: "
+#define HIGH_SCORE_GREETING_SUFFIX ". Press button to start."
+#define SCORE_TEXT_LENGTH 3 //digits of a uint8_t score
+
+/** The welcome text with the high score in it. tinygl keeps scrolling it after
+    interface_set_welcome_text() returns, so it can't live on the stack. */
+static char high_score_greeting[sizeof(HIGH_SCORE_GREETING_TEXT) - 1 + SCORE_TEXT_LENGTH + sizeof(HIGH_SCORE_GREETING_SUFFIX)];
 
 static char gameover_text[] = "GAME OVER. SCORE: ";
 static uint8_t gameover_text_length = 18;
@@ -31,11 +38,20 @@ void interface_init(uint16_t pacer_rate)
     tinygl_text_mode_set(TINYGL_TEXT_MODE_SCROLL);
 }
 
-/** Sets the text that scrolls across the screen to welcome message */
-void interface_set_welcome_text(void)
+/** Sets the text that scrolls across the screen to welcome message
+    @Param high_score the best score so far, shown in the message if non zero */
+void interface_set_welcome_text(uint8_t high_score)
 {
     if (!displaying_greeting) {
-        tinygl_text(GREETING_TEXT);
+        if (high_score == 0) {
+            tinygl_text(GREETING_TEXT);
+        } else {
+            strcpy(high_score_greeting, HIGH_SCORE_GREETING_TEXT);
+            uint8toa(high_score, &high_score_greeting[sizeof(HIGH_SCORE_GREETING_TEXT) - 1], false);
+            strcat(high_score_greeting, HIGH_SCORE_GREETING_SUFFIX);
+
+            tinygl_text(high_score_greeting);
+        }
         displaying_greeting = true;
     }
 }
@@ -11,7 +11,7 @@
 
 void interface_init(uint16_t);
 
-void interface_set_welcome_text(void);
+void interface_set_welcome_text(uint8_t);
 
 void interface_set_gameover_text(uint8_t);
 
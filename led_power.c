@@ -0,0 +1,148 @@
+/** @file led_power.c
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief LED power module (see led_power.h). Only one column of the matrix is
+          driven at a time, so the current drawn in each display slot is about
+          the number of LEDs lit in that column times the current of one LED.
+          Every second the mean current and the most LEDs lit in one slot are
+          logged to telemetry. At the end of a game its total LED energy is
+          logged too, and the host build also prints a summary.
+*/
+
+#include "led_power.h"
+#include "telemetry.h"
+
+#ifdef LED_POWER
+
+#ifndef __AVR__
+#include <stdio.h>
+#endif
+
+static uint16_t slots_per_second;
+
+/* The second so far: display slots, lit LED slots, slots with the blue LED on, most LEDs lit in one slot */
+static uint16_t second_slots;
+static uint16_t second_lit;
+static uint16_t second_status_lit;
+static uint8_t second_peak;
+
+/* The game so far */
+static uint32_t session_slots;
+static uint32_t session_lit;
+static uint32_t session_charge_uas; //microamp seconds
+static uint8_t session_peak;
+
+/*
+Initialise the estimate
+@Param slot_rate the rate led_power_slot() is called at, in Hz
+*/
+void led_power_init(uint16_t slot_rate)
+{
+    slots_per_second = slot_rate;
+}
+
+/* Adds the second so far to the game, and starts the next one. Returns its mean current in microamps. */
+static uint32_t end_second(void)
+{
+    uint32_t current_ua = ((uint32_t) second_lit * LED_POWER_LED_UA + (uint32_t) second_status_lit * LED_POWER_STATUS_LED_UA) / second_slots;
+
+    session_slots += second_slots;
+    session_lit += second_lit;
+    session_charge_uas += current_ua * second_slots / slots_per_second;
+    if (second_peak > session_peak) {
+        session_peak = second_peak;
+    }
+
+    second_slots = 0;
+    second_lit = 0;
+    second_status_lit = 0;
+    second_peak = 0;
+
+    return current_ua;
+}
+
+/* Starts counting a new game from zero */
+void led_power_session_start(void)
+{
+    second_slots = 0;
+    second_lit = 0;
+    second_status_lit = 0;
+    second_peak = 0;
+
+    session_slots = 0;
+    session_lit = 0;
+    session_charge_uas = 0;
+    session_peak = 0;
+}
+
+/*
+Counts one display slot
+@Param pattern the LEDs lit in the column shown this slot, one bit per row
+@Param status_led whether the blue LED is on
+*/
+void led_power_slot(uint8_t pattern, bool status_led)
+{
+    uint8_t lit = 0;
+
+    for (; pattern; pattern &= pattern - 1) {
+        lit++;
+    }
+
+    second_slots++;
+    second_lit += lit;
+    second_status_lit += status_led;
+    if (lit > second_peak) {
+        second_peak = lit;
+    }
+
+    if (second_slots >= slots_per_second) {
+        uint8_t peak = second_peak;
+        uint32_t current_ua = end_second();
+
+        telemetry_record(TELEMETRY_LED_CURRENT, current_ua > UINT16_MAX ? UINT16_MAX : current_ua);
+        telemetry_record(TELEMETRY_LED_PEAK, peak);
+    }
+}
+
+/* Logs the LED energy used by the game that has just ended */
+void led_power_session_end(void)
+{
+    if (second_slots > 0) {
+        end_second();
+    }
+
+    uint32_t energy_mj = session_charge_uas / 100 * LED_POWER_SUPPLY_MV / 10000;
+
+    telemetry_record(TELEMETRY_LED_ENERGY, energy_mj > UINT16_MAX ? UINT16_MAX : energy_mj);
+
+#ifndef __AVR__
+    if (session_slots > 0) {
+        double seconds = (double) session_slots / slots_per_second;
+
+        fprintf(stderr, "led_power: %.1f s, LEDs lit for %.1f s, mean %.2f mA, peak %u LEDs (%.1f mA), %lu mJ\n",
+                seconds, (double) session_lit / slots_per_second, session_charge_uas / seconds / 1000,
+                session_peak, session_peak * LED_POWER_LED_UA / 1000.0, (unsigned long) energy_mj);
+    }
+#endif
+}
+
+#endif
+
+#ifdef LED_POWER_CAP
+
+/*
+Returns the LEDs of a column to light this slot, the first LED_POWER_CAP of them (from the top row down)
+@Param pattern the LEDs still to be shown in the column
+*/
+uint8_t led_power_cap_slice(uint8_t pattern)
+{
+    uint8_t rest = pattern;
+
+    for (uint8_t lit = 0; lit < LED_POWER_CAP && rest; lit++) {
+        rest &= rest - 1;
+    }
+
+    return pattern & ~rest;
+}
+
+#endif
@@ -0,0 +1,64 @@
+/** @file led_power.h
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief Header file for led_power.c, an estimate of the current and energy
+          used by the LED matrix and blue LED, worked out from how many LEDs are
+          lit in each display slot. When LED_POWER is not defined every call
+          compiles away.
+
+    Built with LED_POWER_CAP=n, no more than n LEDs are lit in any display slot:
+    a column with more than n lit LEDs is shown over several slots, n at a time.
+    This caps the peak current, but each of those LEDs is lit for a smaller
+    share of the time, so the display gets dimmer and refreshes more slowly.
+*/
+
+#ifndef LED_POWER_H
+#define LED_POWER_H
+
+#include "system.h"
+
+/** Estimated current through one lit LED of the matrix while its column is driven, in microamps */
+#ifndef LED_POWER_LED_UA
+#define LED_POWER_LED_UA 3000
+#endif
+
+/** Estimated current through the blue LED, in microamps */
+#ifndef LED_POWER_STATUS_LED_UA
+#define LED_POWER_STATUS_LED_UA 2000
+#endif
+
+/** Supply voltage, in millivolts, for turning charge into energy */
+#ifndef LED_POWER_SUPPLY_MV
+#define LED_POWER_SUPPLY_MV 3300
+#endif
+
+#ifdef LED_POWER
+
+void led_power_init(uint16_t);
+
+void led_power_session_start(void);
+
+void led_power_slot(uint8_t, bool);
+
+void led_power_session_end(void);
+
+#else
+
+#define led_power_init(slot_rate)
+#define led_power_session_start()
+#define led_power_slot(pattern, status_led)
+#define led_power_session_end()
+
+#endif
+
+#ifdef LED_POWER_CAP
+
+uint8_t led_power_cap_slice(uint8_t);
+
+#else
+
+#define led_power_cap_slice(pattern) (pattern)
+
+#endif
+
+#endif
@@ -0,0 +1,81 @@
+/** @file level.c
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief Level module, a streaming decoder for authored levels (format in
+          level.h). Levels stay in program memory and are read a byte at a time,
+          so they cost no SRAM beyond the few bytes of decoder state in level_t.
+*/
+
+#include "level.h"
+#include "snapshot.h"
+#include "game.h"
+
+
+/** Starts stepping through a level from its beginning
+    @Param data the level, in program memory */
+void level_start(GAME_CTX_ const uint8_t* data)
+{
+    ctx->level.data = data;
+    ctx->level.pos = 0;
+    ctx->level.run_remaining = 0;
+}
+
+/** Steps the level on by one wall creation slot (or one spawn).
+    @Param arg set to the wall mask for LEVEL_STEP_WALL or the type and position for LEVEL_STEP_SPAWN
+    @Return one of the LEVEL_STEP_ values */
+uint8_t level_next(GAME_CTX_ uint8_t* arg)
+{
+    if (ctx->level.run_remaining == 0) {
+        uint8_t command = pgm_read_byte(&ctx->level.data[ctx->level.pos++]);
+        uint8_t command_arg = command & LEVEL_ARG_MASK;
+
+        switch (command & LEVEL_OP_MASK) {
+        case LEVEL_OP_WALLS:
+            ctx->level.run_step = LEVEL_STEP_WALL;
+            ctx->level.run_mask = pgm_read_byte(&ctx->level.data[ctx->level.pos++]);
+            ctx->level.run_remaining = command_arg + 1;
+            break;
+
+        case LEVEL_OP_GAP:
+            ctx->level.run_step = LEVEL_STEP_GAP;
+            ctx->level.run_remaining = command_arg + 1;
+            break;
+
+        case LEVEL_OP_SPAWN:
+            *arg = pgm_read_byte(&ctx->level.data[ctx->level.pos++]) << 6 | command_arg;
+            return LEVEL_STEP_SPAWN;
+
+        default:
+            if (command_arg == LEVEL_CONTROL_PHASE) {
+                return LEVEL_STEP_PHASE;
+            }
+
+            /* end of the level, go around again */
+            ctx->level.pos = 0;
+            return LEVEL_STEP_GAP;
+        }
+    }
+
+    ctx->level.run_remaining--;
+    *arg = ctx->level.run_mask;
+    return ctx->level.run_step;
+}
+
+/** Saves how far through the level the decoder is */
+void level_save(GAME_CTX_ level_snapshot_t* snapshot)
+{
+    snapshot->pos = ctx->level.pos;
+    snapshot->run_remaining = ctx->level.run_remaining;
+    snapshot->run_step = ctx->level.run_step;
+    snapshot->run_mask = ctx->level.run_mask;
+}
+
+/** Carries on decoding the built in level from a saved position */
+void level_restore(GAME_CTX_ const level_snapshot_t* snapshot)
+{
+    ctx->level.data = level_data;
+    ctx->level.pos = snapshot->pos;
+    ctx->level.run_remaining = snapshot->run_remaining;
+    ctx->level.run_step = snapshot->run_step;
+    ctx->level.run_mask = snapshot->run_mask;
+}
@@ -0,0 +1,77 @@
+/** @file level.h
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief Header file for level.c, defines the authored level format and the
+          functions for stepping through a level.
+
+    A level is a stream of commands, read one wall creation slot at a time. Each
+    command starts with a byte holding an opcode (top 2 bits) and an argument
+    (low 6 bits):
+
+        LEVEL_OP_WALLS   arg = count - 1, then a mask byte. The next count walls
+                         are all the same: bit n set means a wall in column n
+                         (horizontal phase) or row n (vertical phase).
+        LEVEL_OP_GAP     arg = count - 1. No wall is made for the next count slots.
+        LEVEL_OP_SPAWN   arg = row << 3 | col, then a byte holding the ENTITY_
+                         type. The entity appears there, in the same slot as
+                         the command after it.
+        LEVEL_OP_CONTROL arg = LEVEL_CONTROL_PHASE switches phase (taking a slot),
+                         arg = LEVEL_CONTROL_END starts the level over. It
+                         doesn't change phase, so a level switches phase an
+                         even number of times (levelc checks this).
+
+    tools/levelc compiles a text description of a level into this format.
+*/
+
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include "system.h"
+#include "context.h"
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#else
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t*) (addr))
+#endif
+
+#define LEVEL_OP_WALLS 0x00
+#define LEVEL_OP_GAP 0x40
+#define LEVEL_OP_SPAWN 0x80
+#define LEVEL_OP_CONTROL 0xC0
+
+#define LEVEL_OP_MASK 0xC0
+#define LEVEL_ARG_MASK 0x3F
+#define LEVEL_MAX_RUN 64
+
+#define LEVEL_CONTROL_PHASE 0
+#define LEVEL_CONTROL_END 1
+
+/** What the game should do in a wall creation slot, returned by level_next() */
+#define LEVEL_STEP_WALL 0 /* create a wall with the given mask */
+#define LEVEL_STEP_GAP 1 /* create nothing */
+#define LEVEL_STEP_PHASE 2 /* start a phase change */
+#define LEVEL_STEP_SPAWN 3 /* spawn an entity, given as type << 6 | row << 3 | col, then call level_next() again */
+
+/** Where the decoder is up to in a level, part of the game context */
+typedef struct
+{
+    const uint8_t* data;
+    uint16_t pos;
+
+    /* The walls or gaps still to come from the current command */
+    uint8_t run_remaining;
+    uint8_t run_step;
+    uint8_t run_mask;
+
+} level_t;
+
+/** The built in level, in program memory (level_data.c) */
+extern const uint8_t level_data[] PROGMEM;
+
+void level_start(GAME_CTX_ const uint8_t*);
+
+uint8_t level_next(GAME_CTX_ uint8_t*);
+
+#endif
@@ -0,0 +1,21 @@
+/** @file level_data.c
+    @brief The built in level. Generated by tools/levelc from levels/level1.txt, do not edit.
+*/
+
+#include "level.h"
+
+const uint8_t level_data[] PROGMEM = {
+    0x01, 0x1B, 0x01, 0x1D, 0x00, 0x1E, 0x40, 0x00, 0x1D, 0x00, 0x1B, 0x00,
+    0x17, 0x00, 0x0F, 0x40, 0x00, 0x17, 0x02, 0x1B, 0xB0, 0x00, 0xA2, 0x02,
+    0x00, 0x1E, 0x00, 0x1B, 0x00, 0x0F, 0x41, 0x00, 0x0F, 0x00, 0x1B, 0x00,
+    0x1E, 0x41, 0x00, 0x11, 0x00, 0x0E, 0x00, 0x11, 0x00, 0x0E, 0x40, 0x90,
+    0x01, 0x05, 0x17, 0x41, 0x01, 0x0A, 0x01, 0x15, 0x01, 0x0A, 0x42, 0xC0,
+    0x02, 0x67, 0x01, 0x73, 0x01, 0x79, 0x40, 0x00, 0x73, 0x00, 0x67, 0x00,
+    0x4F, 0x00, 0x1F, 0x84, 0x00, 0xA9, 0x02, 0x41, 0x00, 0x7C, 0x00, 0x73,
+    0x00, 0x4F, 0x41, 0x01, 0x55, 0x01, 0x2A, 0x42, 0xC0, 0x00, 0x0F, 0x00,
+    0x1E, 0x00, 0x1B, 0x00, 0x1D, 0x00, 0x17, 0x03, 0x1B, 0x40, 0x00, 0x1E,
+    0x00, 0x0F, 0x00, 0x1E, 0x00, 0x0F, 0x41, 0x9A, 0x00, 0x8C, 0x01, 0x00,
+    0x1D, 0x00, 0x17, 0x00, 0x1D, 0x00, 0x17, 0x43, 0xC0, 0x03, 0x77, 0x01,
+    0x7B, 0x01, 0x77, 0x01, 0x6F, 0x41, 0x00, 0x7E, 0x00, 0x3F, 0x00, 0x78,
+    0x00, 0x0F, 0x43, 0xC0, 0xC1,
+};
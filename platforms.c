@@ -8,8 +8,12 @@
 */
 
 #include "ledmat.h"
-#include <stdlib.h>
 #include "platforms.h"
+#include "player.h"
+#include "rng.h"
+#include "snapshot.h"
+#include "game.h"
+#include "state_hash.h"
 
 #define INITIAL_WALL_SHIFTS_PER_MINUTE 90
 #define INITIAL_NEW_WALLS_PER_MINUTE 30
@@ -17,208 +21,359 @@
 #define MAX_WALL_SHIFTS_PER_MINUTE 180
 #define MAX_NEW_WALLS_PER_MINUTE 50
 
-#define VERTICAL_WALL_SPEED_DIVISOR 1.2 //to balance game
-#define VERTICAL_WALL_CREATION_SPEED_DIVISOR 1.5 //to balance game
+//vertical walls shift 1.2 times and come 1.5 times slower, to balance game
+#define VERTICAL_WALL_SPEED_NUM 5
+#define VERTICAL_WALL_SPEED_DEN 6
+#define VERTICAL_WALL_CREATION_SPEED_NUM 2
+#define VERTICAL_WALL_CREATION_SPEED_DEN 3
 
-static bool phase;
+#define ALL_ROWS_MASK ((1 << LEDMAT_ROWS_NUM) - 1)
+#define ALL_COLS_MASK ((1 << LEDMAT_COLS_NUM) - 1)
 
-static uint8_t wall_shifts_per_minute = INITIAL_WALL_SHIFTS_PER_MINUTE; //one 'shift' is one row or one col
+/* Fastest the player is assumed to move when checking a new wall's hole can be reached. The navswitch is
+   read at 50 Hz, but nobody can push it more than about 10 times a second */
+#define PLAYER_MOVES_PER_MINUTE 600
 
-static uint8_t new_walls_per_minute = INITIAL_NEW_WALLS_PER_MINUTE;
+/* Random holes tried before giving up and putting the hole somewhere the player can reach, this bounds
+   the time taken to make a wall */
+#define MAX_WALL_CANDIDATES 4
 
+/* Sets the walls in a column, the one place wall_cols is written (other than restoring a snapshot) */
+static void set_wall_col(GAME_CTX_ uint8_t col, uint8_t pattern)
+{
+    STATE_HASH_SET(STATE_HASH_WALL_COL + col, ctx->walls.wall_cols[col], pattern);
+}
 
+/* Shifts every row in the matrix down, and clears the top row. */
+static void shift_all_rows_down(GAME_CTX)
+{
+    for (uint8_t col = 0; col < LEDMAT_COLS_NUM; col++) {
+        set_wall_col(CTX_ col, (ctx->walls.wall_cols[col] << 1) & ALL_ROWS_MASK);
+    }
+}
 
-/* The matrix representing the state of the display in regards to the position of walls */
-static uint8_t display_matrix[LEDMAT_ROWS_NUM][LEDMAT_COLS_NUM] = {
-    {0, 0, 0, 0, 0},
-    {0, 0, 0, 0, 0},
-    {0, 0, 0, 0, 0},
-    {0, 0, 0, 0, 0},
-    {0, 0, 0, 0, 0},
-    {0, 0, 0, 0, 0},
-    {0, 0, 0, 0, 0}
-};
+/* Shifts every column in the matrix to the right, and clears the leftmost column */
+static void shift_all_columns_right(GAME_CTX) {
+    for (uint8_t col = LEDMAT_COLS_NUM-1; col > 0; col--) {
+        set_wall_col(CTX_ col, ctx->walls.wall_cols[col-1]);
+    }
 
-/* Initalize platforms, set phase to horizontal platforms */
-void platforms_init(void)
-{
+    set_wall_col(CTX_ 0, 0);
+}
 
-    //init random number generator with a seed
-    srandom(1);
-    phase = PHASE_HORIZONTAL_PLATFORMS;
+/* Creates a new wall in the top row, bit n of mask set for a wall in column n */
+static void create_horizontal_wall_from_mask(GAME_CTX_ uint8_t mask)
+{
+    for (uint8_t col = 0; col < LEDMAT_COLS_NUM; col++) {
+        set_wall_col(CTX_ col, (ctx->walls.wall_cols[col] & ~1) | ((mask >> col) & 1));
+    }
+}
 
+/* Creates a new wall in the left column, bit n of mask set for a wall in row n */
+static void create_vertical_wall_from_mask(GAME_CTX_ uint8_t mask)
+{
+    set_wall_col(CTX_ 0, mask & ALL_ROWS_MASK);
 }
 
-/* Creates a new wall in the top row, with a hole in a random column */
-void create_new_horizontal_wall(void)
+/* Returns a bitmask of the free cells in a row, bit n is column n */
+static uint8_t free_cells_in_row(GAME_CTX_ uint8_t row)
 {
-    uint8_t col_with_hole = random() % LEDMAT_COLS_NUM;
+    uint8_t cells = 0;
 
     for (uint8_t col = 0; col < LEDMAT_COLS_NUM; col++) {
-        display_matrix[0][col] = (col != col_with_hole);
+        cells |= ((ctx->walls.wall_cols[col] >> row) & 1) << col;
     }
 
+    return ~cells & ALL_COLS_MASK;
 }
 
-/* Creates either horizontal or vertical wall depending on the current phase */
-void create_new_wall(void)
+/* Returns a bitmask of the free cells in a column, bit n is row n */
+static uint8_t free_cells_in_col(GAME_CTX_ uint8_t col)
 {
+    return ~ctx->walls.wall_cols[col] & ALL_ROWS_MASK;
+}
 
-    if (phase == PHASE_HORIZONTAL_PLATFORMS) {
-        create_new_horizontal_wall();
-    } else {
-        create_new_vertical_wall();
+/* Operations of each phase, indexed by phase */
+static const phase_ops_t phase_ops[NUM_PHASES] = {
+    [PHASE_HORIZONTAL_PLATFORMS] = {
+        .shift = shift_all_rows_down,
+        .create_from_mask = create_horizontal_wall_from_mask,
+        .free_cells_in_line = free_cells_in_row,
+        .player_line = get_player_row,
+        .player_cell = get_player_col,
+        .line_length = LEDMAT_COLS_NUM,
+        .hole_pattern = 0x01, //one hole
+        .shift_rate_num = 1, .shift_rate_den = 1,
+        .new_wall_rate_num = 1, .new_wall_rate_den = 1,
+        .wrap_cols = true,
+        .wrap_rows = false
+    },
+    [PHASE_VERTICAL_PLATFORMS] = {
+        .shift = shift_all_columns_right,
+        .create_from_mask = create_vertical_wall_from_mask,
+        .free_cells_in_line = free_cells_in_col,
+        .player_line = get_player_col,
+        .player_cell = get_player_row,
+        .line_length = LEDMAT_ROWS_NUM,
+        .hole_pattern = 0x03, //two holes next to each other, so the player is always close to one
+        .shift_rate_num = VERTICAL_WALL_SPEED_NUM, .shift_rate_den = VERTICAL_WALL_SPEED_DEN,
+        .new_wall_rate_num = VERTICAL_WALL_CREATION_SPEED_NUM, .new_wall_rate_den = VERTICAL_WALL_CREATION_SPEED_DEN,
+        .wrap_cols = false,
+        .wrap_rows = true
     }
+};
 
+/* Works out the ticks between wall shifts and new walls, after the phase or a speed changes. This keeps
+   the divisions out of the per tick checks in game.c. */
+static void update_wall_periods(GAME_CTX)
+{
+    ctx->walls.wall_shift_period = ctx->walls.ticks_per_minute / get_wall_shifts_per_minute(CTX);
+    ctx->walls.new_wall_period = ctx->walls.ticks_per_minute / get_new_walls_per_minute(CTX);
 }
 
-/* Shifts every row in the matrix down, and clears the top row. */
-void shift_all_rows_down(void)
+/* Sets the phase and the operations that go with it */
+static void set_phase(GAME_CTX_ uint8_t phase)
 {
-    for (uint8_t row = LEDMAT_ROWS_NUM-1; row > 0; row--) {
-        for (uint8_t col = 0; col < LEDMAT_COLS_NUM; col++) {
-            display_matrix[row][col] = display_matrix[row-1][col];
-        }
-    }
+    STATE_HASH_SET(STATE_HASH_PHASE, ctx->walls.phase, phase);
+    ctx->walls.ops = &phase_ops[phase];
+    update_wall_periods(CTX);
+}
 
+/*
+Initalize platforms, set phase to horizontal platforms
+@Param pacer_rate the rate game_tick() is called at, in Hz
+*/
+void platforms_init(GAME_CTX_ uint16_t pacer_rate)
+{
+
+    //init random number generator with a seed
+    rng_seed(CTX_ 1);
+    ctx->walls.ticks_per_minute = pacer_rate * 60;
+    walls_reset(CTX);
 
-    for (uint8_t col = 0; col < LEDMAT_COLS_NUM; col++) {
-        display_matrix[0][col] = 0;
-    }
 }
 
-/* Creates a new vertical wall on the left column with a hole in random row. */
-void create_new_vertical_wall(void) {
+/* Returns the cells the player could get to in one move from any of the given cells, staying in free ones.
+   The player can wrap around from one end of the line to the other in either phase. */
+static uint8_t spread_one_move(uint8_t reachable, uint8_t free, uint8_t line_length)
+{
+    uint8_t wrapped = ((reachable & 1) << (line_length - 1)) | (reachable >> (line_length - 1));
+
+    return (reachable | reachable << 1 | reachable >> 1 | wrapped) & free;
+}
 
-    uint8_t row_with_hole = random() % LEDMAT_ROWS_NUM;
+/* Returns a bitmask of the cells in the player's line that the player could be in when a wall created now
+   reaches them. Each wall already between the new one and the player passes through the player's line
+   first, leaving time for a few moves after each shift. */
+static uint8_t reachable_cells_for_new_wall(GAME_CTX)
+{
+    const phase_ops_t* ops = ctx->walls.ops;
+    uint8_t line_length = ops->line_length;
+    uint8_t distance = ops->player_line(CTX);
+    uint8_t moves = PLAYER_MOVES_PER_MINUTE / get_wall_shifts_per_minute(CTX);
+    uint8_t reachable = 1 << ops->player_cell(CTX);
+
+    //more moves than this can't reach anywhere new, so the loop below is bounded whatever the speed
+    if (moves > line_length - 1) {
+        moves = line_length - 1;
+    }
 
-    //adjacent to first whole, or on opposite side, so player is always close to a hole
-    uint8_t second_row_with_hole = (row_with_hole + 1) % LEDMAT_ROWS_NUM;
+    //the next shift could be due straight away, so no moves are counted before it
+    for (uint8_t line = distance; line > 1; line--) {
+        uint8_t free = ops->free_cells_in_line(CTX_ line - 1);
 
-    for (uint8_t row = 0; row < LEDMAT_ROWS_NUM; row++) {
-        display_matrix[row][0] = !(row == row_with_hole || row == second_row_with_hole);
+        reachable &= free;
+        for (uint8_t move = 0; move < moves; move++) {
+            reachable = spread_one_move(reachable, free, line_length);
+        }
     }
+
+    return reachable;
 }
 
-/* Shifts every column in the matrix to the right, and clears the leftmost column */
-void shift_all_columns_right(void) {
-    for (uint8_t col = LEDMAT_COLS_NUM-1; col > 0; col--) {
-        for (uint8_t row = 0; row < LEDMAT_ROWS_NUM; row++) {
-            display_matrix[row][col] = display_matrix[row][col-1];
+/* Returns the holes of a new wall whose (first) hole is at pos, the phase's hole pattern rotated along
+   the line so holes past the end wrap round to the start */
+static uint8_t wall_holes_at(GAME_CTX_ uint8_t pos)
+{
+    uint8_t pattern = ctx->walls.ops->hole_pattern;
+    uint8_t line_length = ctx->walls.ops->line_length;
+
+    return ((pattern << pos) | (pattern >> (line_length - pos))) & ((1 << line_length) - 1);
+}
+
+/* Picks random holes for a new wall, trying up to MAX_WALL_CANDIDATES until the player can reach one in
+   time. If none can be, the holes go at the first reachable cell instead (unless the player is already
+   trapped). */
+static uint8_t choose_wall_holes(GAME_CTX)
+{
+    uint8_t line_length = ctx->walls.ops->line_length;
+    uint8_t reachable = reachable_cells_for_new_wall(CTX);
+    uint8_t holes = 0;
+
+    for (uint8_t candidate = 0; candidate < MAX_WALL_CANDIDATES; candidate++) {
+        holes = wall_holes_at(CTX_ rng_next(CTX) % line_length);
+
+        if (holes & reachable) {
+            return holes;
         }
     }
 
-    for (uint8_t row = 0; row < LEDMAT_ROWS_NUM; row++) {
-        display_matrix[row][0] = 0;
+    if (reachable) {
+        holes = wall_holes_at(CTX_ __builtin_ctz(reachable));
     }
+
+    return holes;
 }
 
-/* Shifts walls down/right depending on the current phase */
-void shift_all_walls(void)
+/*
+Creates a new wall in the top row or left column (depending on the current phase) with the given shape.
+@Param mask bit n set for a wall in column n (horizontal phase) or row n (vertical phase)
+*/
+void create_new_wall_from_mask(GAME_CTX_ uint8_t mask)
 {
+    ctx->walls.ops->create_from_mask(CTX_ mask);
+}
 
-    if (phase == PHASE_HORIZONTAL_PLATFORMS) {
-        shift_all_rows_down();
-    } else {
-        shift_all_columns_right();
-    }
+/* Creates a new wall for the current phase, with holes at random cells the player can reach */
+void create_new_wall(GAME_CTX)
+{
+    create_new_wall_from_mask(CTX_ ((1 << ctx->walls.ops->line_length) - 1) & ~choose_wall_holes(CTX));
+}
 
+/* Shifts walls down/right depending on the current phase */
+void shift_all_walls(GAME_CTX)
+{
+    ctx->walls.ops->shift(CTX);
 }
 
 /*
 Returns a number representing the given column of the platform display matrix.
 @Param col the column number to get the current state of
 */
-uint8_t get_col_pattern(uint8_t col)
+uint8_t get_col_pattern(GAME_CTX_ uint8_t col)
 {
-    uint8_t pattern = 0;
-
-    for (uint8_t i = 0; i < LEDMAT_ROWS_NUM; i++) {
-        pattern |= display_matrix[i][col] << i;
-    }
+    return ctx->walls.wall_cols[col];
+}
 
-    return pattern;
+/* Returns the row bitmask of every column (as get_col_pattern), for testing many cells at once */
+const uint8_t* get_wall_cols(GAME_CTX)
+{
+    return ctx->walls.wall_cols;
 }
 
-/* Switches the current mode of wall generation between horizontal and vertical walls. */
-void change_phase(void)
+/* Switches wall generation to the next phase, wrapping back to the first after the last. */
+void change_phase(GAME_CTX)
 {
-    if (phase == PHASE_HORIZONTAL_PLATFORMS) {
-        phase = PHASE_VERTICAL_PLATFORMS;
-    } else {
-        phase = PHASE_HORIZONTAL_PLATFORMS;
-    }
+    set_phase(CTX_ (ctx->walls.phase + 1) % NUM_PHASES);
 }
 
 /* Returns the current phase */
-bool get_phase(void)
+uint8_t get_phase(GAME_CTX)
+{
+    return ctx->walls.phase;
+}
+
+/* Returns the operations of the current phase, for the wrap rules when moving the player */
+const phase_ops_t* get_phase_ops(GAME_CTX)
 {
-    return phase;
+    return ctx->walls.ops;
 }
 
 /* Clear LED matrix, every row and every column set to 0 (off).*/
-void clear_all_walls(void)
+void clear_all_walls(GAME_CTX)
 {
-    for (uint8_t i = 0; i < LEDMAT_ROWS_NUM; i++) {
-        for (uint8_t j = 0; j < LEDMAT_COLS_NUM; j++) {
-            display_matrix[i][j] = 0;
-        }
+    for (uint8_t col = 0; col < LEDMAT_COLS_NUM; col++) {
+        set_wall_col(CTX_ col, 0);
     }
 }
 
-/** Returns number of rows/cols each platform moves per minute modified by a factor of VERTICAL_WALL_SPEED_DIVISOR
+/** Returns number of rows/cols each platform moves per minute, scaled for the current phase
     to improve the gameplay experience */
-uint8_t get_wall_shifts_per_minute(void)
+uint8_t get_wall_shifts_per_minute(GAME_CTX)
 {
-    if (phase == PHASE_HORIZONTAL_PLATFORMS) {
-        return wall_shifts_per_minute;
-    } else {
-        return wall_shifts_per_minute / VERTICAL_WALL_SPEED_DIVISOR;
-    }
+    return (uint16_t) ctx->walls.wall_shifts_per_minute * ctx->walls.ops->shift_rate_num / ctx->walls.ops->shift_rate_den;
 }
 
-/** Returns number of walls to create per minute reduced for vertical walls by a factor of VERTICAL_WALL_CREATION_SPEED_DIVISOR
+/** Returns number of walls to create per minute, scaled for the current phase
     to improve the gameplay experience */
-uint8_t get_new_walls_per_minute(void)
+uint8_t get_new_walls_per_minute(GAME_CTX)
 {
-    if (phase == PHASE_HORIZONTAL_PLATFORMS) {
-        return new_walls_per_minute;
-    } else {
-        return new_walls_per_minute / VERTICAL_WALL_CREATION_SPEED_DIVISOR;
-    }
+    return (uint16_t) ctx->walls.new_walls_per_minute * ctx->walls.ops->new_wall_rate_num / ctx->walls.ops->new_wall_rate_den;
+}
+
+/** Returns the number of ticks between wall shifts at the current speed */
+uint16_t get_wall_shift_period(GAME_CTX)
+{
+    return ctx->walls.wall_shift_period;
+}
+
+/** Returns the number of ticks between new walls at the current speed */
+uint16_t get_new_wall_period(GAME_CTX)
+{
+    return ctx->walls.new_wall_period;
 }
 
 /*
 Increases the rate at which walls shift per minute, cannot exceed MAX_WALL_SHIFTS_PER_MINUTE
 @Param extra_shift_rate the amount to increment the current shift rate (in shifts per minute)
 */
-void increase_wall_shifts_per_minute(uint8_t extra_shift_rate)
+void increase_wall_shifts_per_minute(GAME_CTX_ uint8_t extra_shift_rate)
 {
-    wall_shifts_per_minute += extra_shift_rate;
+    uint8_t wall_shifts_per_minute = ctx->walls.wall_shifts_per_minute + extra_shift_rate;
     if (wall_shifts_per_minute > MAX_WALL_SHIFTS_PER_MINUTE)
         wall_shifts_per_minute = MAX_WALL_SHIFTS_PER_MINUTE;
+
+    STATE_HASH_SET(STATE_HASH_WALL_SHIFT_RATE, ctx->walls.wall_shifts_per_minute, wall_shifts_per_minute);
+    update_wall_periods(CTX);
 }
 
 /*
 Increases the number of walls created, cannot exceed MAX_NEW_WALLS_PER_MINUTE
 @Param extra_creation_rate the amount to increase current creation rate by in new walls per minute
 */
-void increase_new_walls_per_minute(uint8_t extra_creation_rate)
+void increase_new_walls_per_minute(GAME_CTX_ uint8_t extra_creation_rate)
 {
-    new_walls_per_minute += extra_creation_rate;
+    uint8_t new_walls_per_minute = ctx->walls.new_walls_per_minute + extra_creation_rate;
     if (new_walls_per_minute > MAX_NEW_WALLS_PER_MINUTE)
         new_walls_per_minute = MAX_NEW_WALLS_PER_MINUTE;
+
+    STATE_HASH_SET(STATE_HASH_NEW_WALL_RATE, ctx->walls.new_walls_per_minute, new_walls_per_minute);
+    update_wall_periods(CTX);
 }
 
 /**
     Returns wall movement and creation speeds to their start values.
     Primarily to reset game after a gameover.
 */
-void walls_reset(void)
+void walls_reset(GAME_CTX)
 {
-    clear_all_walls();
-    wall_shifts_per_minute = INITIAL_WALL_SHIFTS_PER_MINUTE;
-    new_walls_per_minute = INITIAL_NEW_WALLS_PER_MINUTE;
-    phase = PHASE_HORIZONTAL_PLATFORMS;
+    clear_all_walls(CTX);
+    STATE_HASH_SET(STATE_HASH_WALL_SHIFT_RATE, ctx->walls.wall_shifts_per_minute, INITIAL_WALL_SHIFTS_PER_MINUTE);
+    STATE_HASH_SET(STATE_HASH_NEW_WALL_RATE, ctx->walls.new_walls_per_minute, INITIAL_NEW_WALLS_PER_MINUTE);
+    set_phase(CTX_ PHASE_HORIZONTAL_PLATFORMS);
+
+}
 
+/* Copies the walls, phase and speeds into a snapshot */
+void platforms_save(GAME_CTX_ walls_snapshot_t* snapshot)
+{
+    for (uint8_t col = 0; col < LEDMAT_COLS_NUM; col++) {
+        snapshot->wall_cols[col] = ctx->walls.wall_cols[col];
+    }
+    snapshot->phase = ctx->walls.phase;
+    snapshot->wall_shifts_per_minute = ctx->walls.wall_shifts_per_minute;
+    snapshot->new_walls_per_minute = ctx->walls.new_walls_per_minute;
+}
+
+/* Sets the walls, phase and speeds from a snapshot */
+void platforms_restore(GAME_CTX_ const walls_snapshot_t* snapshot)
+{
+    for (uint8_t col = 0; col < LEDMAT_COLS_NUM; col++) {
+        ctx->walls.wall_cols[col] = snapshot->wall_cols[col];
+    }
+    ctx->walls.phase = snapshot->phase;
+    ctx->walls.wall_shifts_per_minute = snapshot->wall_shifts_per_minute;
+    ctx->walls.new_walls_per_minute = snapshot->new_walls_per_minute;
+    ctx->walls.ops = &phase_ops[ctx->walls.phase];
+    update_wall_periods(CTX);
 }
@@ -7,38 +7,80 @@
 #ifndef PLATFORMS_H
 #define PLATFORMS_H
 
+#include "system.h"
+#include "context.h"
+
 #define PHASE_HORIZONTAL_PLATFORMS 0
 #define PHASE_VERTICAL_PLATFORMS 1
+#define NUM_PHASES 2
 #define MAX_PHASE_SHIFTS_PER_MINUTE 5
 
-void platforms_init(void);
+/** How the walls behave in one phase. Each phase has a const table of these (platforms.c) and
+    change_phase() swaps the table, so nothing else needs to check which phase it is. A new kind of
+    wall is a new table. */
+typedef struct
+{
+    void (*shift)(GAME_CTX); //move every wall one step towards the far edge
+    void (*create_from_mask)(GAME_CTX_ uint8_t); //put a new wall on the near edge
+    uint8_t (*free_cells_in_line)(GAME_CTX_ uint8_t); //bitmask of the free cells in a line parallel to the walls
+    uint8_t (*player_line)(GAME_CTX); //line the player is in, counting from the near edge
+    uint8_t (*player_cell)(GAME_CTX); //cell of that line the player is in
+    uint8_t line_length; //cells along a wall
+    uint8_t hole_pattern; //holes of a new random wall, before rotating along the line
+    uint8_t shift_rate_num, shift_rate_den; //wall shifts per minute are scaled by num / den
+    uint8_t new_wall_rate_num, new_wall_rate_den; //new walls per minute likewise
+    bool wrap_cols; //player moving off the east or west edge comes back on the other
+    bool wrap_rows; //player moving off the north or south edge comes back on the other
+
+} phase_ops_t;
+
+/** State of the walls, part of the game context */
+typedef struct
+{
+    /* The walls on the display, as a bitmask of the rows with a wall in each column
+       (bit 0 is the top row), which is also the pattern ledmat_display_column() takes */
+    uint8_t wall_cols[LEDMAT_COLS_NUM];
+    uint8_t phase; //PHASE_ constant, indexes the phase_ops table
+    uint8_t wall_shifts_per_minute; //one 'shift' is one row or one col
+    uint8_t new_walls_per_minute;
+
+    /* Worked out from the phase and speeds above whenever they change, not saved in snapshots */
+    const phase_ops_t* ops;
+    uint16_t ticks_per_minute;
+    uint16_t wall_shift_period; //ticks between wall shifts
+    uint16_t new_wall_period; //ticks between new walls
+
+} walls_t;
+
+void platforms_init(GAME_CTX_ uint16_t);
 
-void create_new_horizontal_wall(void);
+void create_new_wall(GAME_CTX);
 
-void shift_all_rows_down(void);
+void create_new_wall_from_mask(GAME_CTX_ uint8_t);
 
-void create_new_vertical_wall(void);
+void shift_all_walls(GAME_CTX);
 
-void create_new_wall(void);
+uint8_t get_col_pattern(GAME_CTX_ uint8_t);
 
-void shift_all_columns_right(void);
+const uint8_t* get_wall_cols(GAME_CTX);
 
-void shift_all_walls(void);
+uint8_t get_phase(GAME_CTX);
 
-uint8_t get_col_pattern(uint8_t);
+const phase_ops_t* get_phase_ops(GAME_CTX);
 
-bool get_phase(void);
+void change_phase(GAME_CTX);
 
-void change_phase(void);
+void clear_all_walls(GAME_CTX);
 
-void clear_all_walls(void);
+uint8_t get_wall_shifts_per_minute(GAME_CTX);
+uint8_t get_new_walls_per_minute(GAME_CTX);
 
-uint8_t get_wall_shifts_per_minute(void);
-uint8_t get_new_walls_per_minute(void);
+uint16_t get_wall_shift_period(GAME_CTX);
+uint16_t get_new_wall_period(GAME_CTX);
 
-void increase_wall_shifts_per_minute(uint8_t);
-void increase_new_walls_per_minute(uint8_t);
+void increase_wall_shifts_per_minute(GAME_CTX_ uint8_t);
+void increase_new_walls_per_minute(GAME_CTX_ uint8_t);
 
-void walls_reset(void);
+void walls_reset(GAME_CTX);
 
 #endif
@@ -6,63 +6,62 @@
 */
 
 #include "player.h"
-#include "pio.h"
-
-/** struct to hold player row and col position*/
-static player_pos_t player_pos;
-
-/** whether player led should be on or off */
-static bool player_led_state;
-
-/** useful to set player and powerup led on/off */
-static const pio_t ledmat_rows[] =
-{
-    LEDMAT_ROW1_PIO, LEDMAT_ROW2_PIO, LEDMAT_ROW3_PIO,
-    LEDMAT_ROW4_PIO, LEDMAT_ROW5_PIO, LEDMAT_ROW6_PIO,
-    LEDMAT_ROW7_PIO
-};
+#include "snapshot.h"
+#include "game.h"
+#include "state_hash.h"
 
 /** Initalize player at centre bottom of LEDMAT */
-void player_init(void)
+void player_init(GAME_CTX)
 {
-    player_pos = (player_pos_t) {.row = 6, .col = 2};
-    player_led_state = 0;
+    ctx->player.pos = (player_pos_t) {.row = 6, .col = 2};
+    ctx->player.led_state = 0;
 }
 
 /** Toggle whether player LED should be on or off */
-void toggle_player_led_state(void)
+void toggle_player_led_state(GAME_CTX)
 {
-    player_led_state = !player_led_state;
+    ctx->player.led_state = !ctx->player.led_state;
 }
 
-/** Set LED representing player to on or off depending on player_led_state */
-void set_player_led(void)
+/** Returns the LED representing the player as a column pattern (bit n for row n), 0 while its led state is off */
+uint8_t get_player_led_pattern(GAME_CTX)
 {
-    if (player_led_state) {
-        pio_output_low (ledmat_rows[get_player_row()]);
-    } else {
-        pio_output_high (ledmat_rows[get_player_row()]);
-    }
+    return ctx->player.led_state ? 1 << get_player_row(CTX) : 0;
 }
 
 /* getters and setters */
 
-void set_player_col(uint8_t col)
+void set_player_col(GAME_CTX_ uint8_t col)
+{
+    STATE_HASH_SET(STATE_HASH_PLAYER_COL, ctx->player.pos.col, col);
+}
+
+void set_player_row(GAME_CTX_ uint8_t row)
+{
+    STATE_HASH_SET(STATE_HASH_PLAYER_ROW, ctx->player.pos.row, row);
+}
+
+uint8_t get_player_col(GAME_CTX)
 {
-    player_pos.col = col;
+    return ctx->player.pos.col;
 }
 
-void set_player_row(uint8_t row)
+uint8_t get_player_row(GAME_CTX)
 {
-    player_pos.row = row;
+    return ctx->player.pos.row;
 }
 
-uint8_t get_player_col(void)
+/** Copies the player's position and LED state into a snapshot */
+void player_save(GAME_CTX_ player_snapshot_t* snapshot)
 {
-    return player_pos.col;
+    snapshot->row = ctx->player.pos.row;
+    snapshot->col = ctx->player.pos.col;
+    snapshot->led_state = ctx->player.led_state;
 }
 
-uint8_t get_player_row(void)
+/** Sets the player's position and LED state from a snapshot */
+void player_restore(GAME_CTX_ const player_snapshot_t* snapshot)
 {
-    return player_pos.row;
+    ctx->player.pos = (player_pos_t) {.row = snapshot->row, .col = snapshot->col};
+    ctx->player.led_state = snapshot->led_state;
 }
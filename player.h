@@ -9,6 +9,7 @@
 #define PLAYER_H
 
 #include "system.h"
+#include "context.h"
 
 #define PLAYER_LED_BLINK_RATE 8
 
@@ -20,16 +21,23 @@ typedef struct
 
 } player_pos_t;
 
-void player_init(void);
-void set_powerup_led(void);
+/** State of the player, part of the game context */
+typedef struct
+{
+    player_pos_t pos;
+    bool led_state; /* whether player led should be on or off */
+
+} player_t;
+
+void player_init(GAME_CTX);
 
-void toggle_player_led_state(void);
-void set_player_led(void);
+void toggle_player_led_state(GAME_CTX);
+uint8_t get_player_led_pattern(GAME_CTX);
 
-void set_player_col(uint8_t);
-uint8_t get_player_col(void);
+void set_player_col(GAME_CTX_ uint8_t);
+uint8_t get_player_col(GAME_CTX);
 
-void set_player_row(uint8_t);
-uint8_t get_player_row(void);
+void set_player_row(GAME_CTX_ uint8_t);
+uint8_t get_player_row(GAME_CTX);
 
 #endif
@@ -0,0 +1,36 @@
+/** @file rng.c
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief Random number generator module. A 16 bit xorshift generator, used
+          instead of random() because it is much cheaper on the AVR and its whole
+          state is one word, so it can be saved and restored with the game.
+*/
+
+#include "rng.h"
+#include "game.h"
+
+/** Seeds the generator, a seed of 0 is treated as 1 (0 would only ever produce 0) */
+void rng_seed(GAME_CTX_ uint16_t seed)
+{
+    ctx->rng_state = seed ? seed : 1;
+}
+
+/** Returns the next number in the sequence (never 0, period 65535) */
+uint16_t rng_next(GAME_CTX)
+{
+    ctx->rng_state ^= ctx->rng_state << 7;
+    ctx->rng_state ^= ctx->rng_state >> 9;
+    ctx->rng_state ^= ctx->rng_state << 8;
+
+    return ctx->rng_state;
+}
+
+uint16_t rng_get_state(GAME_CTX)
+{
+    return ctx->rng_state;
+}
+
+void rng_set_state(GAME_CTX_ uint16_t state)
+{
+    rng_seed(CTX_ state);
+}
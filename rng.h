@@ -0,0 +1,21 @@
+/** @file rng.h
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief Header file for rng.c, the game's random number generator.
+*/
+
+#ifndef RNG_H
+#define RNG_H
+
+#include "system.h"
+#include "context.h"
+
+void rng_seed(GAME_CTX_ uint16_t);
+
+uint16_t rng_next(GAME_CTX);
+
+uint16_t rng_get_state(GAME_CTX);
+
+void rng_set_state(GAME_CTX_ uint16_t);
+
+#endif
@@ -0,0 +1,228 @@
+/** @file scores.c
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief Module for keeping high scores and game statistics in EEPROM so they
+          survive power off. Records are appended to a circular log of slots so
+          that writes are spread across the EEPROM (wear levelling). Every record
+          holds the whole table and has a sequence number and CRC, so only the
+          newest valid record ever needs to be read.
+*/
+
+#include "scores.h"
+#include <stddef.h>
+#include <string.h>
+
+#ifdef __AVR__
+#include <avr/eeprom.h>
+#else
+/* There is no EEPROM on the host, so emulate one in RAM. Erased EEPROM reads 0xFF. */
+#define HOST_EEPROM_SIZE 1024
+static uint8_t host_eeprom[HOST_EEPROM_SIZE];
+static bool host_eeprom_initialised = false;
+
+static uint8_t eeprom_read_byte(const uint8_t* addr)
+{
+    if (!host_eeprom_initialised) {
+        memset(host_eeprom, 0xFF, sizeof(host_eeprom));
+        host_eeprom_initialised = true;
+    }
+    return host_eeprom[(uintptr_t) addr];
+}
+
+static void eeprom_update_byte(uint8_t* addr, uint8_t value)
+{
+    eeprom_read_byte(addr);
+    host_eeprom[(uintptr_t) addr] = value;
+}
+
+#define eeprom_is_ready() true
+#endif
+
+#define SCORES_LOG_START 0 /* first EEPROM address of the log */
+#define SCORES_LOG_SLOTS 32 /* number of records the log holds before wrapping */
+
+/* Sequence numbers count modulo a multiple of SCORES_LOG_SLOTS, so slot = seq % SCORES_LOG_SLOTS
+   holds across the wrap, and 0xFFFF (erased EEPROM) is never a valid sequence number */
+#define SCORES_SEQ_MODULUS (0xFFFF - 0xFFFF % SCORES_LOG_SLOTS)
+#define SCORES_SEQ_INVALID 0xFFFF
+
+#define CRC8_POLYNOMIAL 0x07
+
+/** One entry in the EEPROM log. Bytes are written in order, and the CRC covers
+    everything before it, so a record cut short by power off fails its CRC check */
+typedef struct
+{
+    scores_t scores;
+    uint16_t seq;
+    uint8_t crc;
+
+} scores_record_t;
+
+#define SCORES_RECORD_SIZE (sizeof(scores_record_t))
+
+/* RAM copy of the newest record */
+static scores_record_t current;
+
+/* Record waiting to be written to EEPROM, written one byte per call to scores_update() */
+static scores_record_t pending;
+static uint8_t pending_write_index = SCORES_RECORD_SIZE;
+
+/** Returns the EEPROM address of the given byte of a log slot */
+static uint8_t* slot_address(uint8_t slot, uint8_t offset)
+{
+    return (uint8_t*) (uintptr_t) (SCORES_LOG_START + slot * SCORES_RECORD_SIZE + offset);
+}
+
+/** Reads the sequence number stored in a log slot */
+static uint16_t read_slot_seq(uint8_t slot)
+{
+    uint8_t offset = offsetof(scores_record_t, seq);
+
+    return eeprom_read_byte(slot_address(slot, offset))
+           | (uint16_t) eeprom_read_byte(slot_address(slot, offset + 1)) << 8;
+}
+
+/** Reads a whole log slot into record */
+static void read_slot(uint8_t slot, scores_record_t* record)
+{
+    uint8_t* bytes = (uint8_t*) record;
+
+    for (uint8_t i = 0; i < SCORES_RECORD_SIZE; i++) {
+        bytes[i] = eeprom_read_byte(slot_address(slot, i));
+    }
+}
+
+/** Returns the CRC-8 of every byte of a record before the CRC itself */
+static uint8_t record_crc(const scores_record_t* record)
+{
+    const uint8_t* bytes = (const uint8_t*) record;
+    uint8_t crc = 0;
+
+    for (uint8_t i = 0; i < offsetof(scores_record_t, crc); i++) {
+        crc ^= bytes[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ CRC8_POLYNOMIAL : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+/** Finds the slot holding the newest record, or returns SCORES_LOG_SLOTS if the log is empty.
+    Slots 0..newest hold consecutive sequence numbers starting at slot 0's, and every slot after
+    is either erased or left over from the previous lap, so a binary search finds the newest slot
+    in log2(SCORES_LOG_SLOTS) reads instead of scanning the whole log. */
+static uint8_t find_newest_slot(void)
+{
+    uint16_t first_seq = read_slot_seq(0);
+
+    /* slot 0 is either erased, or its write was cut short just after the log wrapped */
+    if (first_seq >= SCORES_SEQ_MODULUS) {
+        return read_slot_seq(SCORES_LOG_SLOTS - 1) < SCORES_SEQ_MODULUS ? SCORES_LOG_SLOTS - 1 : SCORES_LOG_SLOTS;
+    }
+
+    uint8_t low = 0; /* always in the current lap */
+    uint8_t high = SCORES_LOG_SLOTS; /* first slot known to be outside it */
+
+    while (high - low > 1) {
+        uint8_t mid = (low + high) / 2;
+
+        if (read_slot_seq(mid) == (first_seq + mid) % SCORES_SEQ_MODULUS) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/** Loads the newest valid record from EEPROM. Call once at start up, before the welcome screen. */
+void scores_init(void)
+{
+    uint8_t slot = find_newest_slot();
+
+    memset(&current, 0, sizeof(current));
+    current.seq = SCORES_SEQ_INVALID;
+
+    if (slot == SCORES_LOG_SLOTS) {
+        return;
+    }
+
+    /* If the newest record is corrupt, fall back to older ones */
+    for (uint8_t tries = 0; tries < SCORES_LOG_SLOTS; tries++) {
+        scores_record_t record;
+        read_slot(slot, &record);
+
+        if (record.seq < SCORES_SEQ_MODULUS && record_crc(&record) == record.crc) {
+            current = record;
+            return;
+        }
+
+        slot = (slot + SCORES_LOG_SLOTS - 1) % SCORES_LOG_SLOTS;
+    }
+}
+
+/** Returns the high score table and statistics */
+const scores_t* scores_get(void)
+{
+    return &current.scores;
+}
+
+/** Returns the best score ever recorded (0 if no games have been played) */
+uint8_t scores_get_high_score(void)
+{
+    return current.scores.high_scores[0];
+}
+
+/** Adds a finished game to the table and totals, and queues a new record to be written.
+    Nothing is written to EEPROM here, see scores_update().
+    @Param score the final score of the game
+    @Param seconds_survived how long the game lasted in seconds
+    @Param powerups_used how many powerups the player used during the game */
+void scores_record_game(uint8_t score, uint16_t seconds_survived, uint8_t powerups_used)
+{
+    scores_t* scores = &current.scores;
+
+    /* insert score into the table, keeping it in descending order */
+    for (uint8_t i = 0; i < SCORES_TABLE_SIZE; i++) {
+        if (score > scores->high_scores[i]) {
+            uint8_t displaced = scores->high_scores[i];
+            scores->high_scores[i] = score;
+            score = displaced;
+        }
+    }
+
+    scores->games_played++;
+    scores->seconds_survived += seconds_survived;
+    scores->powerups_used += powerups_used;
+
+    /* If the last record never finished writing, it is invalid, so reuse its slot */
+    if (!scores_write_pending()) {
+        current.seq = (current.seq >= SCORES_SEQ_MODULUS) ? 0 : (current.seq + 1) % SCORES_SEQ_MODULUS;
+    }
+    current.crc = record_crc(&current);
+
+    pending = current;
+    pending_write_index = 0;
+}
+
+/** Writes at most one byte of a queued record, without ever waiting on the EEPROM.
+    Only call this outside of gameplay (i.e. while the interface is showing). */
+void scores_update(void)
+{
+    if (!scores_write_pending() || !eeprom_is_ready()) {
+        return;
+    }
+
+    uint8_t slot = pending.seq % SCORES_LOG_SLOTS;
+
+    eeprom_update_byte(slot_address(slot, pending_write_index), ((uint8_t*) &pending)[pending_write_index]);
+    pending_write_index++;
+}
+
+/** Returns true while a record is still being written to EEPROM */
+bool scores_write_pending(void)
+{
+    return pending_write_index < SCORES_RECORD_SIZE;
+}
@@ -0,0 +1,37 @@
+/** @file scores.h
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief Header file for scores.c, declares the persistent high score and
+          statistics struct, and the functions for loading and saving it.
+*/
+
+#ifndef SCORES_H
+#define SCORES_H
+
+#include "system.h"
+
+#define SCORES_TABLE_SIZE 3
+
+/** High score table (best first) and totals across every game played */
+typedef struct
+{
+    uint8_t high_scores[SCORES_TABLE_SIZE];
+    uint16_t games_played;
+    uint32_t seconds_survived;
+    uint16_t powerups_used;
+
+} scores_t;
+
+void scores_init(void);
+
+const scores_t* scores_get(void);
+
+uint8_t scores_get_high_score(void);
+
+void scores_record_game(uint8_t, uint16_t, uint8_t);
+
+void scores_update(void);
+
+bool scores_write_pending(void);
+
+#endif
@@ -0,0 +1,35 @@
+/** @file snapshot.c
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief Snapshot module, for saving the whole game state between ticks and
+          putting it back later. Saving and restoring just copy a fixed number of
+          bytes, so the host can cheaply try many futures from the same point.
+*/
+
+#include "snapshot.h"
+#include "rng.h"
+#include "game.h"
+#include "state_hash.h"
+
+/** Saves the state of every module into snapshot. Call between ticks of a game in progress. */
+void snapshot_save(GAME_CTX_ game_snapshot_t* snapshot)
+{
+    game_save(CTX_ &snapshot->game);
+    platforms_save(CTX_ &snapshot->walls);
+    player_save(CTX_ &snapshot->player);
+    entity_save(CTX_ &snapshot->entities);
+    level_save(CTX_ &snapshot->level);
+    snapshot->rng_state = rng_get_state(CTX);
+}
+
+/** Puts every module back into the state saved in snapshot */
+void snapshot_restore(GAME_CTX_ const game_snapshot_t* snapshot)
+{
+    game_restore(CTX_ &snapshot->game);
+    platforms_restore(CTX_ &snapshot->walls);
+    player_restore(CTX_ &snapshot->player);
+    entity_restore(CTX_ &snapshot->entities);
+    level_restore(CTX_ &snapshot->level);
+    rng_set_state(CTX_ snapshot->rng_state);
+    state_hash_rebuild(CTX);
+}
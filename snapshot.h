@@ -0,0 +1,86 @@
+/** @file snapshot.h
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief Header file for snapshot.c. Declares the game snapshot, which holds
+          everything needed to carry on a game from the tick it was taken on, and
+          the functions each module provides to fill in and restore its part.
+*/
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "system.h"
+#include "context.h"
+#include "entity.h"
+#include "game.h"
+
+/** Walls, phase and wall speeds (platforms.c) */
+typedef struct
+{
+    uint8_t wall_cols[LEDMAT_COLS_NUM];
+    uint8_t phase;
+    uint8_t wall_shifts_per_minute;
+    uint8_t new_walls_per_minute;
+
+} walls_snapshot_t;
+
+/** Player position and LED state (player.c) */
+typedef struct
+{
+    uint8_t row;
+    uint8_t col;
+    bool led_state;
+
+} player_snapshot_t;
+
+/** Entity pool (entity.c), each entity packed into a byte as type << 6 | row << 3 | col */
+typedef struct
+{
+    uint8_t active_slots;
+    uint8_t cell[ENTITY_CAPACITY];
+    uint8_t state[ENTITY_CAPACITY];
+
+} entity_snapshot_t;
+
+/** Position in the authored level (level.c) */
+typedef struct
+{
+    uint16_t pos;
+    uint8_t run_remaining;
+    uint8_t run_step;
+    uint8_t run_mask;
+
+} level_snapshot_t;
+
+/** The whole game, a few dozen bytes */
+typedef struct
+{
+    game_state_t game;
+    walls_snapshot_t walls;
+    player_snapshot_t player;
+    entity_snapshot_t entities;
+    level_snapshot_t level;
+    uint16_t rng_state;
+
+} game_snapshot_t;
+
+void snapshot_save(GAME_CTX_ game_snapshot_t*);
+
+void snapshot_restore(GAME_CTX_ const game_snapshot_t*);
+
+void game_save(GAME_CTX_ game_state_t*);
+void game_restore(GAME_CTX_ const game_state_t*);
+
+void platforms_save(GAME_CTX_ walls_snapshot_t*);
+void platforms_restore(GAME_CTX_ const walls_snapshot_t*);
+
+void player_save(GAME_CTX_ player_snapshot_t*);
+void player_restore(GAME_CTX_ const player_snapshot_t*);
+
+void entity_save(GAME_CTX_ entity_snapshot_t*);
+void entity_restore(GAME_CTX_ const entity_snapshot_t*);
+
+void level_save(GAME_CTX_ level_snapshot_t*);
+void level_restore(GAME_CTX_ const level_snapshot_t*);
+
+#endif
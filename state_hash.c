@@ -0,0 +1,96 @@
+/** @file state_hash.c
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief State hash module (see state_hash.h). The hash is Zobrist style:
+          every value of every field has a pseudo random 16 bit key, and the
+          hash is the XOR of the keys of the current values. Changing a field
+          is then just two keys and two XORs, whatever the size of the state.
+          Keys are mixed up from the field and value with a couple of
+          multiplies, which the AVR does in hardware, rather than kept in a table.
+*/
+
+#include "state_hash.h"
+#include "game.h"
+#include "telemetry.h"
+
+#ifdef STATE_HASH
+
+#ifndef __AVR__
+#include <stdio.h>
+#endif
+
+/** Returns the key for a field holding a value */
+static uint16_t state_hash_key(uint8_t field, uint8_t value)
+{
+    uint16_t key = ((uint16_t) field << 8 | value) ^ 0x5BD1;
+
+    key *= 0x9E37;
+    key ^= key >> 7;
+    key *= 0x2C1B;
+    key ^= key >> 9;
+
+    return key;
+}
+
+/** Updates the hash for a field changing value, use STATE_HASH_SET rather than calling this */
+void state_hash_change(GAME_CTX_ uint8_t field, uint8_t old_value, uint8_t new_value)
+{
+    ctx->state_hash ^= state_hash_key(field, old_value) ^ state_hash_key(field, new_value);
+}
+
+/** Returns the hash of the current state worked out from scratch */
+uint16_t state_hash_compute(GAME_CTX)
+{
+    uint16_t hash = 0;
+
+    for (uint8_t col = 0; col < LEDMAT_COLS_NUM; col++) {
+        hash ^= state_hash_key(STATE_HASH_WALL_COL + col, ctx->walls.wall_cols[col]);
+    }
+
+    hash ^= state_hash_key(STATE_HASH_PHASE, ctx->walls.phase);
+    hash ^= state_hash_key(STATE_HASH_WALL_SHIFT_RATE, ctx->walls.wall_shifts_per_minute);
+    hash ^= state_hash_key(STATE_HASH_NEW_WALL_RATE, ctx->walls.new_walls_per_minute);
+    hash ^= state_hash_key(STATE_HASH_PLAYER_ROW, ctx->player.pos.row);
+    hash ^= state_hash_key(STATE_HASH_PLAYER_COL, ctx->player.pos.col);
+    hash ^= state_hash_key(STATE_HASH_SCORE, ctx->game.score);
+    hash ^= state_hash_key(STATE_HASH_HAS_POWERUP, ctx->game.player_has_powerup);
+
+    for (uint8_t type = 0; type < ENTITY_NUM_TYPES; type++) {
+        for (uint8_t col = 0; col < LEDMAT_COLS_NUM; col++) {
+            hash ^= state_hash_key(STATE_HASH_OCCUPANCY + type * LEDMAT_COLS_NUM + col, ctx->entities.occupancy[type][col]);
+        }
+    }
+
+    return hash;
+}
+
+/** Works the hash out from scratch, after the state has been reset or restored as a whole */
+void state_hash_rebuild(GAME_CTX)
+{
+    ctx->state_hash = state_hash_compute(CTX);
+}
+
+uint16_t state_hash_get(GAME_CTX)
+{
+    return ctx->state_hash;
+}
+
+/** Logs the hash to telemetry every STATE_HASH_PERIOD ticks of a game. The host build also checks it
+    against the hash worked out from scratch, which catches a change made without STATE_HASH_SET. */
+void state_hash_tick(GAME_CTX)
+{
+    if (ctx->game.game_tick_counter % STATE_HASH_PERIOD != 0) {
+        return;
+    }
+
+    telemetry_record(TELEMETRY_STATE_HASH, ctx->state_hash);
+
+#ifndef __AVR__
+    if (ctx->state_hash != state_hash_compute(CTX)) {
+        fprintf(stderr, "state_hash: hash is %04X but the state hashes to %04X\n", ctx->state_hash, state_hash_compute(CTX));
+        state_hash_rebuild(CTX);
+    }
+#endif
+}
+
+#endif
@@ -0,0 +1,61 @@
+/** @file state_hash.h
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief Header file for state_hash.c, a rolling hash of the game state for
+          checking two builds (or the host and the funkit) play a game the same
+          way. When STATE_HASH is not defined the hash compiles away.
+
+    The hash covers the walls, phase, wall speeds, player position, entity
+    positions, score and whether the player holds a powerup. Each of these is a
+    numbered field; every change to one goes through STATE_HASH_SET, which
+    keeps the hash up to date there and then.
+*/
+
+#ifndef STATE_HASH_H
+#define STATE_HASH_H
+
+#include "system.h"
+#include "context.h"
+
+/** Hashed fields */
+#define STATE_HASH_WALL_COL 0 /* + col */
+#define STATE_HASH_PHASE 5
+#define STATE_HASH_WALL_SHIFT_RATE 6
+#define STATE_HASH_NEW_WALL_RATE 7
+#define STATE_HASH_PLAYER_ROW 8
+#define STATE_HASH_PLAYER_COL 9
+#define STATE_HASH_SCORE 10
+#define STATE_HASH_HAS_POWERUP 11
+#define STATE_HASH_OCCUPANCY 12 /* + entity type * LEDMAT_COLS_NUM + col */
+
+/** Ticks between each hash logged to telemetry, must divide into PACER_RATE */
+#ifndef STATE_HASH_PERIOD
+#define STATE_HASH_PERIOD 50
+#endif
+
+#ifdef STATE_HASH
+
+/** Sets a hashed field (an 8 bit lvalue) to a new value, updating the hash */
+#define STATE_HASH_SET(field, lvalue, value) \
+    do { uint8_t new_value_ = (value); state_hash_change(CTX_ (field), (lvalue), new_value_); (lvalue) = new_value_; } while (0)
+
+void state_hash_change(GAME_CTX_ uint8_t, uint8_t, uint8_t);
+
+uint16_t state_hash_compute(GAME_CTX);
+
+void state_hash_rebuild(GAME_CTX);
+
+uint16_t state_hash_get(GAME_CTX);
+
+void state_hash_tick(GAME_CTX);
+
+#else
+
+#define STATE_HASH_SET(field, lvalue, value) ((lvalue) = (value))
+
+#define state_hash_rebuild(ctx)
+#define state_hash_tick(ctx)
+
+#endif
+
+#endif
@@ -0,0 +1,221 @@
+/** @file telemetry.c
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief Telemetry module. Game events and tick timings are packed into small
+          binary records and queued in a ring buffer, which is drained to the USB
+          serial link (or a file on the host) while the game loop is idle. If the
+          buffer is full, records are dropped and counted rather than waiting,
+          so telemetry can never stall the game loop.
+*/
+
+#ifdef TELEMETRY
+
+#include "telemetry.h"
+
+#ifdef __AVR__
+#include "timer.h"
+#include "usb_cdc.h"
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#endif
+
+#define RING_SIZE 128 /* bytes, must be a power of two */
+#define RING_MASK (RING_SIZE - 1)
+
+#define MAX_DRAIN_BYTES_PER_TICK 32
+
+/* Single producer (telemetry_record) and single consumer (telemetry_drain): head
+   is only written by the producer and tail only by the consumer, so no locking is
+   needed even if the drain is moved into an interrupt */
+static uint8_t ring[RING_SIZE];
+static volatile uint8_t ring_head = 0;
+static volatile uint8_t ring_tail = 0;
+
+static uint16_t dropped_records = 0;
+
+static uint16_t tick = 0;
+static uint16_t tick_period_us;
+
+
+#ifdef __AVR__
+
+static timer_tick_t tick_begin_time;
+
+/** Notes the time a tick begins */
+static void time_mark(void)
+{
+    tick_begin_time = timer_get();
+}
+
+/** Returns the microseconds since time_mark(). The 16 bit timer wraps about every 2 s, so the
+    difference is taken in timer ticks before scaling, which stays right across a wrap. */
+static uint32_t time_since_mark_us(void)
+{
+    timer_tick_t elapsed = timer_get() - tick_begin_time;
+
+    return (uint32_t) elapsed * (1000000UL / TIMER_RATE);
+}
+
+static void link_init(void)
+{
+    usb_cdc_init();
+}
+
+/** Returns true if the link can take another byte right now */
+static bool link_ready(void)
+{
+    usb_cdc_update();
+    return usb_cdc_configured_p() && usb_cdc_write_ready_p();
+}
+
+static void link_write(uint8_t byte)
+{
+    usb_cdc_putc(byte);
+}
+
+#else
+
+static FILE* link_file = NULL;
+
+static uint32_t tick_begin_time;
+
+static uint32_t time_now_us(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec * 1000000UL + now.tv_nsec / 1000;
+}
+
+static void time_mark(void)
+{
+    tick_begin_time = time_now_us();
+}
+
+static uint32_t time_since_mark_us(void)
+{
+    return time_now_us() - tick_begin_time;
+}
+
+/** Opens the file named by $TELEMETRY_FILE ("-" for stdout), which may also be a pipe. If it isn't
+    set nothing is written, and records are dropped as if the link were never ready. */
+static void link_init(void)
+{
+    const char* path = getenv("TELEMETRY_FILE");
+
+    if (path == NULL) {
+        return;
+    }
+
+    link_file = strcmp(path, "-") == 0 ? stdout : fopen(path, "wb");
+}
+
+static bool link_ready(void)
+{
+    return link_file != NULL;
+}
+
+static void link_write(uint8_t byte)
+{
+    putc(byte, link_file);
+}
+
+#endif
+
+
+/** Returns how many bytes are free in the ring buffer */
+static uint8_t ring_free(void)
+{
+    return RING_SIZE - 1 - ((ring_head - ring_tail) & RING_MASK);
+}
+
+/** Queues a record, without checking for space */
+static void ring_put_record(uint8_t type, uint16_t value)
+{
+    uint8_t record[TELEMETRY_RECORD_SIZE] = {
+        TELEMETRY_SYNC, type, tick & 0xFF, tick >> 8, value & 0xFF, value >> 8
+    };
+    uint8_t head = ring_head;
+
+    for (uint8_t i = 0; i < TELEMETRY_RECORD_SIZE; i++) {
+        ring[head] = record[i];
+        head = (head + 1) & RING_MASK;
+    }
+
+    /* publish the record only once all of it is in the buffer */
+    ring_head = head;
+}
+
+/** Initialise telemetry and the link it is sent over
+    @Param pacer_rate the rate of the game loop, in Hz */
+void telemetry_init(uint16_t pacer_rate)
+{
+    link_init();
+    tick_period_us = 1000000UL / pacer_rate;
+    telemetry_record(TELEMETRY_START, pacer_rate);
+}
+
+/** Marks the start of a game loop tick, call just after pacer_wait() */
+void telemetry_tick_begin(void)
+{
+    tick++;
+    time_mark();
+}
+
+/** Marks the end of a game loop tick, recording how long it took */
+void telemetry_tick_end(void)
+{
+    if (tick == 0) {
+        return;
+    }
+
+    uint32_t duration = time_since_mark_us();
+
+    if (duration > UINT16_MAX) {
+        duration = UINT16_MAX;
+    }
+
+    telemetry_record(duration > tick_period_us ? TELEMETRY_OVERRUN : TELEMETRY_TICK, duration);
+}
+
+/** Queues a record to be sent, or drops it if there is no room
+    @Param type one of the TELEMETRY_ event types
+    @Param value event specific value, see telemetry.h */
+void telemetry_record(uint8_t type, uint16_t value)
+{
+    /* room is kept for a TELEMETRY_DROPPED record so drops are always reported */
+    if (dropped_records > 0) {
+        if (ring_free() < 2 * TELEMETRY_RECORD_SIZE) {
+            dropped_records++;
+            return;
+        }
+        ring_put_record(TELEMETRY_DROPPED, dropped_records);
+        dropped_records = 0;
+    }
+
+    if (ring_free() < 2 * TELEMETRY_RECORD_SIZE) {
+        dropped_records++;
+        return;
+    }
+
+    ring_put_record(type, value);
+}
+
+/** Sends queued bytes over the link, as many as it takes without waiting
+    (up to MAX_DRAIN_BYTES_PER_TICK). Call when the game loop is otherwise idle. */
+void telemetry_drain(void)
+{
+    uint8_t tail = ring_tail;
+
+    for (uint8_t i = 0; i < MAX_DRAIN_BYTES_PER_TICK && tail != ring_head && link_ready(); i++) {
+        link_write(ring[tail]);
+        tail = (tail + 1) & RING_MASK;
+    }
+
+    ring_tail = tail;
+}
+
+#endif
@@ -0,0 +1,59 @@
+/** @file telemetry.h
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief Header file for telemetry.c, defines the telemetry record format and
+          event types. When TELEMETRY is not defined every call compiles away.
+*/
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "system.h"
+
+/** Every record is TELEMETRY_RECORD_SIZE bytes, little endian:
+    sync (TELEMETRY_SYNC), event type, tick (16 bits), value (16 bits) */
+#define TELEMETRY_SYNC 0xA5
+#define TELEMETRY_RECORD_SIZE 6
+
+/** Event types, the meaning of the value is given for each */
+#define TELEMETRY_START 0       /* value: pacer rate in Hz */
+#define TELEMETRY_TICK 1        /* value: time the tick took in microseconds */
+#define TELEMETRY_OVERRUN 2     /* value: time the tick took in microseconds */
+#define TELEMETRY_WALL_SHIFT 3  /* value: phase */
+#define TELEMETRY_WALL_CREATE 4 /* value: score after the wall was created */
+#define TELEMETRY_PHASE 5       /* value: new phase */
+#define TELEMETRY_SPAWN 6       /* value: entity type << 12 | row << 8 | col of the new entity */
+#define TELEMETRY_INPUT 7       /* value: navswitch direction, or TELEMETRY_INPUT_BUTTON */
+#define TELEMETRY_COLLISION 8   /* value: row << 8 | col of the player */
+#define TELEMETRY_POWERUP 9     /* value: 0 collected, 1 used */
+#define TELEMETRY_DROPPED 10    /* value: records dropped since the last one of these */
+#define TELEMETRY_STATE_HASH 11 /* value: state hash (state_hash.h), every STATE_HASH_PERIOD ticks */
+#define TELEMETRY_LED_CURRENT 12 /* value: estimated mean LED current over the last second in microamps (led_power.h) */
+#define TELEMETRY_LED_PEAK 13   /* value: most LEDs lit in one display slot over the last second */
+#define TELEMETRY_LED_ENERGY 14 /* value: estimated LED energy of the game just ended in millijoules */
+
+#define TELEMETRY_INPUT_BUTTON 0xFF
+
+#ifdef TELEMETRY
+
+void telemetry_init(uint16_t);
+
+void telemetry_tick_begin(void);
+
+void telemetry_tick_end(void);
+
+void telemetry_record(uint8_t, uint16_t);
+
+void telemetry_drain(void);
+
+#else
+
+#define telemetry_init(pacer_rate)
+#define telemetry_tick_begin()
+#define telemetry_tick_end()
+#define telemetry_record(type, value)
+#define telemetry_drain()
+
+#endif
+
+#endif
@@ -0,0 +1,207 @@
+/** @file batch.c
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief Host tool that plays many independent games at once, each in its own
+          game context (built with GAME_REENTRANT, see context.h), split across
+          threads. Each game is played by a simple bot that heads for the hole in
+          the next wall, and the scores and times survived are summed up at the end.
+          Built with STATE_HASH it also folds every game's state hash, tick by
+          tick, into one digest: two builds that play every game the same way
+          print the same digest.
+          Usage: batch [GAMES] [THREADS] [SEED]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include "../game.h"
+#include "../rng.h"
+#include "../state_hash.h"
+
+#define TICKS_PER_SECOND 500 /* PACER_RATE in game.c */
+#define INPUT_PERIOD 10 /* the navswitch is read at 50 Hz */
+#define MAX_GAME_SECONDS 600
+
+typedef struct
+{
+    uint8_t score;
+    uint16_t seconds;
+    unsigned long ticks;
+    uint16_t digest; /* state hashes of every tick folded together */
+    unsigned long hash_errors; /* ticks where the hash didn't match the state */
+
+} result_t;
+
+typedef struct
+{
+    unsigned first_game;
+    unsigned num_games;
+    unsigned stride;
+    unsigned seed;
+    result_t* results;
+
+} worker_t;
+
+/** Returns true if there is a wall in a cell, treating cells off the board as walls */
+static bool is_wall(GAME_CTX_ int row, int col)
+{
+    if (row < 0 || row >= LEDMAT_ROWS_NUM || col < 0 || col >= LEDMAT_COLS_NUM) {
+        return true;
+    }
+
+    return get_col_pattern(CTX_ col) & (1 << row);
+}
+
+/** Picks the bot's input: step towards the hole in the nearest wall coming at the player, or if the
+    wall is about to hit and there is no way out, use a powerup (if it has one) */
+static uint8_t bot_input(GAME_CTX)
+{
+    int row = get_player_row(CTX);
+    int col = get_player_col(CTX);
+    bool horizontal = get_phase(CTX) == PHASE_HORIZONTAL_PLATFORMS;
+    int size = horizontal ? LEDMAT_COLS_NUM : LEDMAT_ROWS_NUM;
+    int pos = horizontal ? col : row;
+
+    /* horizontal walls come down from above the player, vertical walls from the left */
+    for (int distance = 1; distance <= (horizontal ? row : col); distance++) {
+        uint8_t wall = 0;
+
+        for (int i = 0; i < size; i++) {
+            if (horizontal ? is_wall(CTX_ row - distance, i) : is_wall(CTX_ i, col - distance)) {
+                wall |= 1 << i;
+            }
+        }
+
+        if (wall == 0) {
+            continue;
+        }
+        if (!(wall & (1 << pos))) {
+            return 0;
+        }
+
+        for (int step = 1; step < size; step++) {
+            if (pos - step >= 0 && !(wall & (1 << (pos - step)))) {
+                if (!(horizontal ? is_wall(CTX_ row, col - 1) : is_wall(CTX_ row - 1, col))) {
+                    return 1 << (horizontal ? NAVSWITCH_WEST : NAVSWITCH_NORTH);
+                }
+                break;
+            }
+            if (pos + step < size && !(wall & (1 << (pos + step)))) {
+                if (!(horizontal ? is_wall(CTX_ row, col + 1) : is_wall(CTX_ row + 1, col))) {
+                    return 1 << (horizontal ? NAVSWITCH_EAST : NAVSWITCH_SOUTH);
+                }
+                break;
+            }
+        }
+
+        return distance == 1 ? GAME_INPUT_BUTTON : 0;
+    }
+
+    return 0;
+}
+
+/** Plays one game to the end (or MAX_GAME_SECONDS) */
+static result_t play_game(unsigned seed)
+{
+    game_ctx_t game;
+    game_ctx_t* ctx = &game;
+    result_t result = {0, 0, 0, 0, 0};
+
+    game_init(CTX);
+    rng_seed(CTX_ seed);
+    game_start(CTX_ false);
+
+    while (!game_is_over(CTX) && result.ticks < (unsigned long) MAX_GAME_SECONDS * TICKS_PER_SECOND) {
+        game_tick(CTX_ result.ticks % INPUT_PERIOD == 0 ? bot_input(CTX) : 0);
+        result.ticks++;
+
+#ifdef STATE_HASH
+        result.digest = (result.digest * 31) ^ state_hash_get(CTX);
+        if (state_hash_get(CTX) != state_hash_compute(CTX)) {
+            result.hash_errors++;
+            state_hash_rebuild(CTX);
+        }
+#endif
+    }
+
+    result.score = ctx->game.score;
+    result.seconds = ctx->game.seconds_survived;
+    return result;
+}
+
+static void* worker(void* arg)
+{
+    worker_t* work = arg;
+
+    for (unsigned game = work->first_game; game < work->num_games; game += work->stride) {
+        work->results[game] = play_game(work->seed + game);
+    }
+
+    return NULL;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned num_games = argc > 1 ? strtoul(argv[1], NULL, 0) : 1000;
+    unsigned num_threads = argc > 2 ? strtoul(argv[2], NULL, 0) : 4;
+    unsigned seed = argc > 3 ? strtoul(argv[3], NULL, 0) : 1;
+
+    if (num_games == 0 || num_threads == 0) {
+        fprintf(stderr, "usage: %s [GAMES] [THREADS] [SEED]\n", argv[0]);
+        return 2;
+    }
+
+    result_t* results = calloc(num_games, sizeof(result_t));
+    worker_t* workers = calloc(num_threads, sizeof(worker_t));
+    pthread_t* threads = calloc(num_threads, sizeof(pthread_t));
+    struct timespec start, end;
+
+    if (results == NULL || workers == NULL || threads == NULL) {
+        perror("batch");
+        return 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (unsigned i = 0; i < num_threads; i++) {
+        workers[i] = (worker_t) {i, num_games, num_threads, seed, results};
+        pthread_create(&threads[i], NULL, worker, &workers[i]);
+    }
+
+    for (unsigned i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    unsigned long total_score = 0, total_seconds = 0, total_ticks = 0, hash_errors = 0;
+    uint16_t digest = 0;
+    uint8_t best_score = 0;
+
+    for (unsigned game = 0; game < num_games; game++) {
+        total_score += results[game].score;
+        total_seconds += results[game].seconds;
+        total_ticks += results[game].ticks;
+        digest = (digest * 31) ^ results[game].digest;
+        hash_errors += results[game].hash_errors;
+        if (results[game].score > best_score) {
+            best_score = results[game].score;
+        }
+    }
+
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("games %u, threads %u, seed %u\n", num_games, num_threads, seed);
+    printf("score: mean %.2f, best %u\n", (double) total_score / num_games, best_score);
+    printf("survived: mean %.1f s\n", (double) total_seconds / num_games);
+    printf("ticks %lu in %.3f s (%.0f ticks/s)\n", total_ticks, elapsed, total_ticks / elapsed);
+#ifdef STATE_HASH
+    printf("state digest %04X, %lu ticks with a stale hash\n", digest, hash_errors);
+#endif
+
+    free(results);
+    free(workers);
+    free(threads);
+    return 0;
+}
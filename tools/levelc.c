@@ -0,0 +1,211 @@
+/** @file levelc.c
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief Host tool that compiles a text level description into the packed
+          level format (see level.h), written out as C source for level_data.c.
+          Usage: levelc level.txt > level_data.c
+
+    One command per line, lines starting with # are comments:
+
+        walls MASK [COUNT]  COUNT (default 1) walls, MASK is # for wall and . for
+                            hole, one character per column (horizontal phase,
+                            5 left to right) or row (vertical phase, 7 top to bottom)
+        gap [COUNT]         COUNT (default 1) slots with no new wall
+        phase               switch between horizontal and vertical walls
+        powerup ROW COL     a powerup appears at ROW, COL
+        hazard ROW COL      a hazard appears at ROW, COL, and moves along the row
+        bonus ROW COL       a bonus pickup appears at ROW, COL
+        end                 end of the level (optional), it then starts over
+
+    A level starts in the horizontal phase and has to end in it too, since it
+    starts over without changing phase. Repeated walls and gaps are run length
+    encoded.
+*/
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../level.h"
+#include "../entity.h"
+
+#define MAX_LEVEL_BYTES 32768
+#define HORIZONTAL_MASK_LENGTH 5 /* LEDMAT_COLS_NUM */
+#define VERTICAL_MASK_LENGTH 7 /* LEDMAT_ROWS_NUM */
+#define MAX_ROW 6
+#define MAX_COL 4
+#define BYTES_PER_LINE 12
+
+static uint8_t output[MAX_LEVEL_BYTES];
+static size_t output_length = 0;
+
+/* The run being built up, flushed when a different command comes along */
+static int run_op = -1;
+static uint8_t run_mask;
+static unsigned long run_count = 0;
+
+static unsigned long total_walls = 0;
+
+
+static void emit(uint8_t byte)
+{
+    if (output_length == MAX_LEVEL_BYTES) {
+        fprintf(stderr, "levelc: level is too big\n");
+        exit(1);
+    }
+    output[output_length++] = byte;
+}
+
+/** Writes out the current run, split into commands of at most LEVEL_MAX_RUN */
+static void flush_run(void)
+{
+    while (run_count > 0) {
+        unsigned long count = run_count < LEVEL_MAX_RUN ? run_count : LEVEL_MAX_RUN;
+
+        emit(run_op | (count - 1));
+        if (run_op == LEVEL_OP_WALLS) {
+            emit(run_mask);
+        }
+        run_count -= count;
+    }
+
+    run_op = -1;
+}
+
+/** Adds count walls or gaps, extending the current run if it's the same */
+static void add_run(int op, uint8_t mask, unsigned long count)
+{
+    if (op != run_op || (op == LEVEL_OP_WALLS && mask != run_mask)) {
+        flush_run();
+        run_op = op;
+        run_mask = mask;
+    }
+
+    run_count += count;
+}
+
+/** Parses a mask like "##.##", returns -1 if it isn't valid
+    @Param line_length the most cells a wall has in the current phase */
+static int parse_mask(const char* text, size_t line_length)
+{
+    size_t length = strlen(text);
+    int mask = 0;
+
+    if (length == 0 || length > line_length) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < length; i++) {
+        if (text[i] == '#') {
+            mask |= 1 << i;
+        } else if (text[i] != '.') {
+            return -1;
+        }
+    }
+
+    return mask;
+}
+
+/** Returns the ENTITY_ type a spawn command places, or -1 if it isn't one */
+static int spawn_type(const char* command)
+{
+    if (strcmp(command, "powerup") == 0) {
+        return ENTITY_POWERUP;
+    } else if (strcmp(command, "hazard") == 0) {
+        return ENTITY_HAZARD;
+    } else if (strcmp(command, "bonus") == 0) {
+        return ENTITY_BONUS;
+    }
+
+    return -1;
+}
+
+static void syntax_error(const char* path, int line_number, const char* message)
+{
+    fprintf(stderr, "%s:%d: %s\n", path, line_number, message);
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s level.txt > level_data.c\n", argv[0]);
+        return 2;
+    }
+
+    FILE* in = fopen(argv[1], "r");
+    char line[256];
+    int line_number = 0;
+    bool vertical = false;
+
+    if (in == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    while (fgets(line, sizeof(line), in) != NULL) {
+        char command[16] = "";
+        char mask_text[16] = "";
+        unsigned long count = 1;
+        unsigned row, col;
+
+        line_number++;
+        if (sscanf(line, "%15s", command) != 1 || command[0] == '#') {
+            continue;
+        }
+
+        if (strcmp(command, "walls") == 0) {
+            size_t line_length = vertical ? VERTICAL_MASK_LENGTH : HORIZONTAL_MASK_LENGTH;
+
+            if (sscanf(line, "%*s %15s %lu", mask_text, &count) < 1 || parse_mask(mask_text, line_length) < 0 || count == 0) {
+                syntax_error(argv[1], line_number, vertical ? "expected: walls MASK [COUNT], with MASK at most 7 long in the vertical phase"
+                                                            : "expected: walls MASK [COUNT], with MASK at most 5 long in the horizontal phase");
+            }
+            add_run(LEVEL_OP_WALLS, parse_mask(mask_text, line_length), count);
+            total_walls += count;
+        } else if (strcmp(command, "gap") == 0) {
+            sscanf(line, "%*s %lu", &count);
+            if (count == 0) {
+                syntax_error(argv[1], line_number, "expected: gap [COUNT]");
+            }
+            add_run(LEVEL_OP_GAP, 0, count);
+        } else if (strcmp(command, "phase") == 0) {
+            flush_run();
+            emit(LEVEL_OP_CONTROL | LEVEL_CONTROL_PHASE);
+            vertical = !vertical;
+        } else if (spawn_type(command) >= 0) {
+            if (sscanf(line, "%*s %u %u", &row, &col) != 2 || row > MAX_ROW || col > MAX_COL) {
+                syntax_error(argv[1], line_number, "expected: powerup, hazard or bonus ROW COL");
+            }
+            flush_run();
+            emit(LEVEL_OP_SPAWN | row << 3 | col);
+            emit(spawn_type(command));
+        } else if (strcmp(command, "end") == 0) {
+            break;
+        } else {
+            syntax_error(argv[1], line_number, "unknown command");
+        }
+    }
+
+    if (vertical) {
+        syntax_error(argv[1], line_number, "level ends in the vertical phase, so it would start over with the walls the wrong way round (add a phase)");
+    }
+
+    flush_run();
+    emit(LEVEL_OP_CONTROL | LEVEL_CONTROL_END);
+    fclose(in);
+
+    printf("/** @file level_data.c\n");
+    printf("    @brief The built in level. Generated by tools/levelc from %s, do not edit.\n", argv[1]);
+    printf("*/\n\n");
+    printf("#include \"level.h\"\n\n");
+    printf("const uint8_t level_data[] PROGMEM = {");
+    for (size_t i = 0; i < output_length; i++) {
+        printf("%s0x%02X,", i % BYTES_PER_LINE == 0 ? "\n    " : " ", output[i]);
+    }
+    printf("\n};\n");
+
+    fprintf(stderr, "levelc: %lu walls in %lu bytes\n", total_walls, (unsigned long) output_length);
+    return 0;
+}
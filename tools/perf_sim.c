@@ -0,0 +1,298 @@
+/** @file perf_sim.c
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief Host tool that runs the real atmega32u2 game under simavr, with no kit
+          needed. Navswitch and button presses are injected from a script, and
+          the trace markers written by a PERF_MARKERS build (see trace.h) are used
+          to count the exact cycles of every main loop tick and every subroutine.
+          Exits with failure if the worst tick takes more than the given cycles.
+          Usage: perf_sim game-perf.out script.txt max_tick_cycles [seconds]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_io.h"
+#include "avr_ioport.h"
+
+#define MCU_NAME "atmega32u2"
+#define DEFAULT_FREQUENCY 8000000 /* UCFK4 clock, used if the ELF doesn't say */
+#define DEFAULT_SECONDS 30
+
+/* Data space addresses of the general purpose IO registers used for markers */
+#define GPIOR0_ADDR 0x3E
+#define GPIOR1_ADDR 0x4A
+#define GPIOR2_ADDR 0x4B
+
+/* Marker kinds, must match trace.h */
+#define TRACE_MARK_TICK 1
+#define TRACE_MARK_BEGIN 2
+#define TRACE_MARK_END 3
+#define TRACE_MARK_INSTANT 4
+
+#define MAX_NAME_LENGTH 32
+#define MAX_SPAN_DEPTH 8
+#define MAX_SPAN_NAMES 32
+#define MAX_SCRIPT_EVENTS 1024
+
+/* The span that the game loop spends idle in, not counted as tick work */
+#define IDLE_SPAN_NAME "pacer_wait"
+
+/** A kit input and the pin it is on (from the UCFK4 target.h) */
+typedef struct
+{
+    const char* name;
+    char port;
+    uint8_t pin;
+    uint8_t pressed_level;
+
+} input_t;
+
+static const input_t inputs[] = {
+    {"north", 'C', 6, 0},
+    {"east", 'C', 7, 0},
+    {"south", 'C', 5, 0},
+    {"west", 'C', 2, 0},
+    {"push", 'C', 4, 0},
+    {"button", 'D', 7, 1},
+};
+
+#define NUM_INPUTS (sizeof(inputs) / sizeof(inputs[0]))
+
+/** A scripted input change */
+typedef struct
+{
+    uint64_t cycle;
+    uint8_t input;
+    bool pressed;
+
+} script_event_t;
+
+/** Cycle counts for every span with the same name */
+typedef struct
+{
+    char name[MAX_NAME_LENGTH];
+    uint32_t calls;
+    uint64_t total_cycles;
+    uint64_t max_cycles;
+
+} span_stats_t;
+
+static script_event_t script[MAX_SCRIPT_EVENTS];
+static int script_length = 0;
+
+static span_stats_t span_stats[MAX_SPAN_NAMES];
+static int num_span_names = 0;
+
+static struct {
+    int stats;
+    uint64_t start;
+} span_stack[MAX_SPAN_DEPTH];
+static int span_depth = 0;
+
+static uint64_t tick_start = 0;
+static uint64_t tick_idle_cycles = 0;
+static uint64_t tick_total_cycles = 0;
+static uint64_t tick_max_cycles = 0;
+static uint64_t tick_max_at = 0;
+static uint32_t ticks = 0;
+
+
+/** Reads the script: one "time_ms input pressed|released" per line, # for comments */
+static bool read_script(const char* path, uint32_t frequency)
+{
+    FILE* file = fopen(path, "r");
+    char line[128];
+
+    if (file == NULL) {
+        perror(path);
+        return false;
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL && script_length < MAX_SCRIPT_EVENTS) {
+        unsigned long time_ms;
+        char input[16];
+        char state[16];
+
+        if (line[0] == '#' || sscanf(line, "%lu %15s %15s", &time_ms, input, state) != 3) {
+            continue;
+        }
+
+        for (uint8_t i = 0; i < NUM_INPUTS; i++) {
+            if (strcmp(input, inputs[i].name) == 0) {
+                script[script_length++] = (script_event_t) {
+                    .cycle = (uint64_t) time_ms * frequency / 1000,
+                    .input = i,
+                    .pressed = strcmp(state, "pressed") == 0
+                };
+            }
+        }
+    }
+
+    fclose(file);
+    return true;
+}
+
+/** Drives an input pin to its pressed or released level */
+static void set_input(avr_t* avr, uint8_t input, bool pressed)
+{
+    avr_irq_t* irq = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(inputs[input].port), inputs[input].pin);
+    uint8_t level = pressed ? inputs[input].pressed_level : !inputs[input].pressed_level;
+
+    avr_raise_irq(irq, level);
+}
+
+/** Returns the stats entry for the span whose name string is at addr in flash */
+static int find_span_stats(avr_t* avr, uint16_t addr)
+{
+    char name[MAX_NAME_LENGTH];
+    int i;
+
+    for (i = 0; i < MAX_NAME_LENGTH - 1 && addr + i <= avr->flashend && avr->flash[addr + i] != '\0'; i++) {
+        name[i] = avr->flash[addr + i];
+    }
+    name[i] = '\0';
+
+    for (i = 0; i < num_span_names; i++) {
+        if (strcmp(span_stats[i].name, name) == 0) {
+            return i;
+        }
+    }
+
+    if (num_span_names == MAX_SPAN_NAMES) {
+        return -1;
+    }
+
+    strcpy(span_stats[num_span_names].name, name);
+    return num_span_names++;
+}
+
+/** Called by simavr whenever the game writes a marker to GPIOR0 */
+static void marker_write(avr_t* avr, avr_io_addr_t addr, uint8_t kind, void* param)
+{
+    uint16_t name_addr = avr->data[GPIOR1_ADDR] << 8 | avr->data[GPIOR2_ADDR];
+    (void) param;
+
+    avr->data[addr] = kind;
+
+    switch (kind) {
+    case TRACE_MARK_TICK:
+        if (ticks > 0) {
+            uint64_t busy = avr->cycle - tick_start - tick_idle_cycles;
+
+            tick_total_cycles += busy;
+            if (busy > tick_max_cycles) {
+                tick_max_cycles = busy;
+                tick_max_at = ticks;
+            }
+        }
+        ticks++;
+        tick_start = avr->cycle;
+        tick_idle_cycles = 0;
+        break;
+
+    case TRACE_MARK_BEGIN:
+        if (span_depth < MAX_SPAN_DEPTH) {
+            span_stack[span_depth].stats = find_span_stats(avr, name_addr);
+            span_stack[span_depth].start = avr->cycle;
+        }
+        span_depth++;
+        break;
+
+    case TRACE_MARK_END:
+        if (span_depth > 0 && --span_depth < MAX_SPAN_DEPTH && span_stack[span_depth].stats >= 0) {
+            span_stats_t* stats = &span_stats[span_stack[span_depth].stats];
+            uint64_t cycles = avr->cycle - span_stack[span_depth].start;
+
+            stats->calls++;
+            stats->total_cycles += cycles;
+            if (cycles > stats->max_cycles) {
+                stats->max_cycles = cycles;
+            }
+            if (strcmp(stats->name, IDLE_SPAN_NAME) == 0) {
+                tick_idle_cycles += cycles;
+            }
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 4) {
+        fprintf(stderr, "usage: %s game-perf.out script.txt max_tick_cycles [seconds]\n", argv[0]);
+        return 2;
+    }
+
+    uint64_t max_tick_cycles = strtoull(argv[3], NULL, 10);
+    uint32_t seconds = argc > 4 ? strtoul(argv[4], NULL, 10) : DEFAULT_SECONDS;
+
+    elf_firmware_t firmware;
+    memset(&firmware, 0, sizeof(firmware));
+    if (elf_read_firmware(argv[1], &firmware) != 0) {
+        fprintf(stderr, "%s: can't read firmware %s\n", argv[0], argv[1]);
+        return 2;
+    }
+    if (firmware.frequency == 0) {
+        firmware.frequency = DEFAULT_FREQUENCY;
+    }
+
+    avr_t* avr = avr_make_mcu_by_name(MCU_NAME);
+    avr_init(avr);
+    avr_load_firmware(avr, &firmware);
+    avr_register_io_write(avr, GPIOR0_ADDR, marker_write, NULL);
+
+    if (!read_script(argv[2], avr->frequency)) {
+        return 2;
+    }
+
+    /* nothing pulls the inputs up in the simulator, so start them all released */
+    for (uint8_t i = 0; i < NUM_INPUTS; i++) {
+        set_input(avr, i, false);
+    }
+
+    uint64_t end_cycle = (uint64_t) seconds * avr->frequency;
+    int next_event = 0;
+
+    while (avr->cycle < end_cycle) {
+        while (next_event < script_length && script[next_event].cycle <= avr->cycle) {
+            set_input(avr, script[next_event].input, script[next_event].pressed);
+            next_event++;
+        }
+
+        int state = avr_run(avr);
+        if (state == cpu_Done || state == cpu_Crashed) {
+            fprintf(stderr, "%s: simulation stopped early\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("%-32s %8s %10s %10s\n", "span", "calls", "avg", "max");
+    for (int i = 0; i < num_span_names; i++) {
+        printf("%-32s %8lu %10lu %10lu\n", span_stats[i].name, (unsigned long) span_stats[i].calls,
+               (unsigned long) (span_stats[i].calls ? span_stats[i].total_cycles / span_stats[i].calls : 0),
+               (unsigned long) span_stats[i].max_cycles);
+    }
+
+    printf("\n%lu ticks, avg %lu cycles, worst %lu cycles (tick %lu), limit %lu\n",
+           (unsigned long) ticks, (unsigned long) (ticks > 1 ? tick_total_cycles / (ticks - 1) : 0),
+           (unsigned long) tick_max_cycles, (unsigned long) tick_max_at, (unsigned long) max_tick_cycles);
+
+    if (ticks < 2) {
+        fprintf(stderr, "%s: no tick markers seen, was the game built with PERF_MARKERS?\n", argv[0]);
+        return 1;
+    }
+
+    if (tick_max_cycles > max_tick_cycles) {
+        fprintf(stderr, "%s: worst tick took %lu cycles, more than %lu\n", argv[0],
+                (unsigned long) tick_max_cycles, (unsigned long) max_tick_cycles);
+        return 1;
+    }
+
+    return 0;
+}
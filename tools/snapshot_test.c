@@ -0,0 +1,131 @@
+/** @file snapshot_test.c
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief Host test for snapshot.c. One game is played with random inputs, and
+          every so often it is saved and restored into a second, freshly
+          initialised game context. Both games are then ticked in lockstep with
+          the same inputs, and their display, state hash, score and whether the
+          game is over are compared every tick, starting with the first frame
+          after the restore. Exits non zero at the first difference.
+          Built with GAME_REENTRANT and STATE_HASH, like tools/batch.
+          Usage: snapshot_test [SEED]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../game.h"
+#include "../rng.h"
+#include "../snapshot.h"
+#include "../state_hash.h"
+
+#define INPUT_PERIOD 10 /* the navswitch is read at 50 Hz */
+#define SNAPSHOT_PERIOD 97 /* prime, so snapshots land all over the wall and entity cycles */
+#define LOCKSTEP_TICKS 500
+#define NUM_SNAPSHOTS 500
+
+/** Picks a random input from the test's own generator, so the games' generators are left alone */
+static uint8_t random_input(uint32_t* seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+
+    switch ((*seed >> 16) % 8) {
+    case 0: return 1 << NAVSWITCH_NORTH;
+    case 1: return 1 << NAVSWITCH_SOUTH;
+    case 2: return 1 << NAVSWITCH_EAST;
+    case 3: return 1 << NAVSWITCH_WEST;
+    case 4: return GAME_INPUT_BUTTON;
+    default: return 0;
+    }
+}
+
+/** Runs one tick, starting a new game first if the last one is over */
+static void step(GAME_CTX_ uint8_t input, bool level)
+{
+    if (game_is_over(CTX)) {
+        game_start(CTX_ level);
+    }
+    game_tick(CTX_ input);
+}
+
+/** Returns true if two games look and hash the same, printing what differs if not */
+static bool same_game(game_ctx_t* a, game_ctx_t* b, unsigned snapshot, unsigned tick)
+{
+    bool same = true;
+
+    for (uint8_t col = 0; col < LEDMAT_COLS_NUM; col++) {
+        uint8_t pattern_a = game_get_col_pattern(a, col);
+        uint8_t pattern_b = game_get_col_pattern(b, col);
+
+        if (pattern_a != pattern_b) {
+            printf("snapshot %u tick %u: column %u is %02x, restored %02x\n", snapshot, tick, col, pattern_a, pattern_b);
+            same = false;
+        }
+    }
+    if (state_hash_get(a) != state_hash_get(b)) {
+        printf("snapshot %u tick %u: state hash %04x, restored %04x\n", snapshot, tick, state_hash_get(a), state_hash_get(b));
+        same = false;
+    }
+    if (state_hash_get(b) != state_hash_compute(b)) {
+        printf("snapshot %u tick %u: restored state hash %04x doesn't match its state %04x\n",
+               snapshot, tick, state_hash_get(b), state_hash_compute(b));
+        same = false;
+    }
+    if (a->game.score != b->game.score || game_is_over(a) != game_is_over(b)) {
+        printf("snapshot %u tick %u: score %u%s, restored %u%s\n", snapshot, tick,
+               a->game.score, game_is_over(a) ? " (over)" : "", b->game.score, game_is_over(b) ? " (over)" : "");
+        same = false;
+    }
+
+    return same;
+}
+
+/** Plays a game, restoring it from a snapshot every SNAPSHOT_PERIOD ticks and checking the copy against it */
+static bool test_game(unsigned seed, bool level)
+{
+    static game_ctx_t a, b;
+    uint32_t input_seed = seed;
+    unsigned tick = 0;
+
+    game_init(&a);
+    rng_seed(&a, seed);
+    game_start(&a, level);
+
+    for (unsigned snapshot = 0; snapshot < NUM_SNAPSHOTS; snapshot++) {
+        game_snapshot_t saved;
+
+        for (unsigned i = 0; i < SNAPSHOT_PERIOD; i++, tick++) {
+            step(&a, tick % INPUT_PERIOD == 0 ? random_input(&input_seed) : 0, level);
+        }
+        if (game_is_over(&a)) {
+            game_start(&a, level);
+        }
+
+        snapshot_save(&a, &saved);
+        game_init(&b);
+        snapshot_restore(&b, &saved);
+
+        if (!same_game(&a, &b, snapshot, 0)) {
+            return false;
+        }
+        for (unsigned i = 1; i <= LOCKSTEP_TICKS; i++, tick++) {
+            uint8_t input = tick % INPUT_PERIOD == 0 ? random_input(&input_seed) : 0;
+
+            step(&a, input, level);
+            step(&b, input, level);
+            if (!same_game(&a, &b, snapshot, i)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned seed = argc > 1 ? strtoul(argv[1], NULL, 0) : 1;
+    bool passed = test_game(seed, false) && test_game(seed, true);
+
+    printf("snapshot_test: %s\n", passed ? "passed" : "FAILED");
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,73 @@
+/** @file telemetry_decode.c
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief Host tool that decodes a binary telemetry stream (see telemetry.h)
+          into CSV. Reads the file given as an argument, or stdin.
+          Usage: telemetry_decode [telemetry.bin] > telemetry.csv
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "../telemetry.h"
+
+static const char* event_names[] = {
+    "start", "tick", "overrun", "wall_shift", "wall_create", "phase",
+    "spawn", "input", "collision", "powerup", "dropped", "state_hash",
+    "led_current", "led_peak", "led_energy"
+};
+
+#define NUM_EVENT_NAMES (sizeof(event_names) / sizeof(event_names[0]))
+
+int main(int argc, char** argv)
+{
+    FILE* in = argc > 1 ? fopen(argv[1], "rb") : stdin;
+
+    if (in == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    uint8_t record[TELEMETRY_RECORD_SIZE];
+    uint8_t length = 0;
+    uint32_t tick_wraps = 0;
+    uint16_t last_tick = 0;
+    unsigned long skipped_bytes = 0;
+    int c;
+
+    printf("tick,event,value\n");
+
+    while ((c = getc(in)) != EOF) {
+        record[length++] = c;
+
+        /* resynchronise if the stream was cut or corrupted: drop a byte at a time until
+           what is left starts with the sync byte and a known event type */
+        while (length > 0 && (record[0] != TELEMETRY_SYNC || (length > 1 && record[1] >= NUM_EVENT_NAMES))) {
+            memmove(record, &record[1], --length);
+            skipped_bytes++;
+        }
+
+        if (length < TELEMETRY_RECORD_SIZE) {
+            continue;
+        }
+        length = 0;
+
+        uint8_t type = record[1];
+        uint16_t tick = record[2] | record[3] << 8;
+        uint16_t value = record[4] | record[5] << 8;
+
+        /* ticks only go forwards, so a smaller tick means the 16 bit counter wrapped */
+        if (tick < last_tick) {
+            tick_wraps++;
+        }
+        last_tick = tick;
+
+        printf("%lu,%s,%u\n", (unsigned long) tick_wraps << 16 | tick, event_names[type], value);
+    }
+
+    if (skipped_bytes > 0) {
+        fprintf(stderr, "telemetry_decode: skipped %lu bytes of unsynchronised data\n", skipped_bytes);
+    }
+
+    return 0;
+}
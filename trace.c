@@ -0,0 +1,152 @@
+/** @file trace.c
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief Trace module for the host build. Writes a timeline in the Chrome
+          trace event JSON format (open it in chrome://tracing or Perfetto) to the
+          file named by $TRACE_FILE. Subroutines are spans timed in real host
+          nanoseconds, and every event also carries the game loop tick it
+          happened on and that tick's time on the kit (tick * pacer period), so
+          subroutines landing on the same tick can be seen side by side.
+*/
+
+#if defined(TRACE) && !defined(__AVR__)
+
+#include "trace.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define TRACE_PID 1
+#define TRACE_TID 1
+
+static FILE* trace_file = NULL;
+static bool first_event = true;
+
+static uint32_t tick = 0;
+static bool tick_open = false;
+static uint32_t tick_period_us;
+
+static uint64_t start_time_ns;
+
+/* Set by SIGINT or SIGTERM. The game loop never returns, so this is how the trace gets finished. */
+static volatile sig_atomic_t stop_requested = 0;
+
+
+/** Returns host time in nanoseconds since trace_init() */
+static uint64_t time_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec - start_time_ns;
+}
+
+/** Writes one trace event. Timestamps in the format are microseconds, so the
+    nanoseconds go after the decimal point */
+static void trace_event(const char* name, char phase)
+{
+    if (trace_file == NULL) {
+        return;
+    }
+
+    uint64_t now = time_now_ns();
+
+    fprintf(trace_file, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":%d,\"tid\":%d,%s"
+            "\"args\":{\"tick\":%lu,\"virtual_us\":%llu}}",
+            first_event ? "" : ",\n", name, phase,
+            (unsigned long long) (now / 1000), (unsigned) (now % 1000), TRACE_PID, TRACE_TID,
+            phase == 'i' ? "\"s\":\"p\"," : "",
+            (unsigned long) tick, (unsigned long long) tick * tick_period_us);
+
+    first_event = false;
+}
+
+/** Finishes the JSON array, run at exit */
+static void trace_close(void)
+{
+    if (trace_file != NULL) {
+        trace_tick_end();
+        fprintf(trace_file, "\n]\n");
+        fclose(trace_file);
+        trace_file = NULL;
+    }
+}
+
+/** Signal handler, asks the game loop to stop at the end of the tick */
+static void request_stop(int signal)
+{
+    (void) signal;
+    stop_requested = 1;
+}
+
+/** Starts tracing if $TRACE_FILE is set
+    @Param pacer_rate the rate of the game loop, in Hz */
+void trace_init(uint16_t pacer_rate)
+{
+    const char* path = getenv("TRACE_FILE");
+
+    if (path == NULL || (trace_file = fopen(path, "w")) == NULL) {
+        return;
+    }
+
+    tick_period_us = 1000000UL / pacer_rate;
+    start_time_ns = 0;
+    start_time_ns = time_now_ns();
+
+    fprintf(trace_file, "[\n");
+    atexit(trace_close);
+
+    /* a second signal, before the loop comes round, kills the game as usual */
+    struct sigaction action = {.sa_handler = request_stop, .sa_flags = SA_RESETHAND};
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+}
+
+/** Advances the virtual tick, call once per game loop just after pacer_wait(). Each tick is
+    also a span, so the subroutines that ran on the same tick are grouped under it */
+void trace_tick(void)
+{
+    tick++;
+    trace_event("tick", 'B');
+    tick_open = true;
+}
+
+/** Closes the tick's span once its work is done, before telemetry is sent and pacer_wait(),
+    so the span's length is the time the tick took rather than always one pacer period. The
+    trace is flushed once per tick, and if the game was interrupted it exits here, between
+    ticks, so the trace is finished at exit. */
+void trace_tick_end(void)
+{
+    if (tick_open) {
+        trace_event("tick", 'E');
+        tick_open = false;
+        fflush(trace_file);
+    }
+
+    if (stop_requested) {
+        stop_requested = 0; //trace_close() comes back here at exit
+        exit(EXIT_SUCCESS);
+    }
+}
+
+/** Opens a span */
+void trace_begin(const char* name)
+{
+    trace_event(name, 'B');
+}
+
+/** Closes the span opened by the matching trace_begin() */
+void trace_end(const char* name)
+{
+    trace_event(name, 'E');
+}
+
+/** Records a single point in time event */
+void trace_instant(const char* name)
+{
+    trace_event(name, 'i');
+}
+
+#endif
@@ -0,0 +1,72 @@
+/** @file trace.h
+    @authors Ryan Croucher (rcr69) & Jeremy Roberts (jro162)
+    @date 18 October 2021
+    @brief Header file for trace.c, timeline tracing for the host build. On the
+          AVR with PERF_MARKERS defined, trace points instead write markers to the
+          GPIOR registers for tools/perf_sim to time. Otherwise every call compiles away.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "system.h"
+
+#if defined(TRACE) && !defined(__AVR__)
+
+void trace_init(uint16_t);
+
+void trace_tick(void);
+
+void trace_tick_end(void);
+
+void trace_begin(const char*);
+
+void trace_end(const char*);
+
+void trace_instant(const char*);
+
+/** Runs call (a subroutine call) as a span named after the subroutine */
+#define TRACE_CALL(name, call) do { trace_begin(name); call; trace_end(name); } while (0)
+
+#elif defined(PERF_MARKERS) && defined(__AVR__)
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+/** Marker kinds written to GPIOR0. GPIOR1:GPIOR2 hold the address of the name string, which is
+    kept in program memory (PSTR) so the perf build uses the same RAM as the shipped one, and the
+    simulator reads it from flash. Writing GPIOR0 last triggers the simulator. */
+#define TRACE_MARK_TICK 1
+#define TRACE_MARK_BEGIN 2
+#define TRACE_MARK_END 3
+#define TRACE_MARK_INSTANT 4
+
+#define TRACE_MARK(kind, name) do { \
+        GPIOR2 = (uint16_t) (name) & 0xFF; \
+        GPIOR1 = (uint16_t) (name) >> 8; \
+        GPIOR0 = (kind); \
+    } while (0)
+
+#define trace_init(pacer_rate)
+#define trace_tick() TRACE_MARK(TRACE_MARK_TICK, 0)
+#define trace_tick_end()
+#define trace_begin(name) TRACE_MARK(TRACE_MARK_BEGIN, PSTR(name))
+#define trace_end(name) TRACE_MARK(TRACE_MARK_END, PSTR(name))
+#define trace_instant(name) TRACE_MARK(TRACE_MARK_INSTANT, PSTR(name))
+
+#define TRACE_CALL(name, call) do { trace_begin(name); call; trace_end(name); } while (0)
+
+#else
+
+#define trace_init(pacer_rate)
+#define trace_tick()
+#define trace_tick_end()
+#define trace_begin(name)
+#define trace_end(name)
+#define trace_instant(name)
+
+#define TRACE_CALL(name, call) call
+
+#endif
+
+#endif